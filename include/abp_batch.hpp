@@ -0,0 +1,55 @@
+/** \brief Batch mode of the ABP simulator
+ *
+ * ./bin/ABP writes one run to fixed paths, so two runs can't share a directory.
+ * The batch mode runs many control inputs in one process, concurrently, and writes
+ * the outputs of every input to its own directory, given by a template where
+ * {name} is replaced with the file name of the input without extension:
+ *      ./data/batch/{name}/abp_output.txt, file_mod_output.csv, time_stats_output.csv,
+ *                          delivery_report.csv, timeline.csv
+ * Each thread keeps its topology between inputs (abp_runner.hpp). A combined summary
+ * table, one row per input in the order of the inputs, is written at the end:
+ *      Input,Events,Packets,Delivered,Transmissions,Retransmissions,RetransmissionRatio,
+ *      Goodput,MaxDelay,MinDelay,AvgDelay,Secs
+ *
+ * Usage: ./bin/ABP --batch <directory | list file | input,input,...> [end time]
+ *                  [output directory template] [summary file] [--threads N] [--bucket t]
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+#ifndef __ABP_BATCH_HPP_
+#define __ABP_BATCH_HPP_
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief      Control inputs of a batch
+ * A directory gives its input*.txt files in name order (its traces, e.g.
+ * data/abp_output.txt, aren't inputs), a comma separated list gives
+ * its files, a file whose lines all name existing files gives these files and any
+ * other file is a control input by itself.
+ *
+ * @param[in]  spec  directory, list file or comma separated inputs
+ * @return     The control inputs, empty if none is found
+ */
+vector<string> batch_inputs(const string &);
+
+/**
+ * @brief      Runs the control inputs of a batch
+ *
+ * @param[in]  inputs           control inputs
+ * @param[in]  end_time         end time of every run
+ * @param[in]  output_template  output directory of a run, {name} is the name of the input
+ * @param[in]  summary_file     file receiving the combined summary table
+ * @param[in]  threads          number of runs at the same time
+ * @param[in]  bucket_ms        width of the buckets of the timelines in milliseconds
+ * @return     0 if every run wrote its outputs, 1 otherwise
+ */
+int run_batch(const vector<string> &, const string &, const string &, const string &, int, long long);
+
+#endif /**< __ABP_BATCH_HPP_ */
@@ -0,0 +1,83 @@
+/** \brief Analytical model of the delay and throughput of the ABP simulator
+ *
+ * With losses drawn independently in each subnet and link delays drawn independently
+ * of them, a packet goes through a small Markov chain: preparation, transit of the
+ * packet, preparation of the ack by the receiver, transit of the ack, and a timeout
+ * followed by a new preparation whenever one of the two transits loses its message.
+ * Every attempt succeeds with probability s = (1 - loss)^2, so the number of failed
+ * attempts K is geometric and the delay of a packet (first send to ack, as in the
+ * delivery report) is
+ *      delay = K * (timeout + sender preparation) + RTT
+ *      RTT   = link delay + receiver preparation + link delay
+ * where RTT is the round trip of the attempt that succeeds. The sender accepts the ack
+ * of an attempt whenever it comes, so the chain is exact as long as every round trip
+ * ends before the next attempt is sent (RTT < timeout + sender preparation): the
+ * attempts then never share a subnet or the receiver. A sender with packets always
+ * waiting prepares the next packet as soon as one is acked, so its throughput is
+ * 1 / (sender preparation + E[delay]).
+ *
+ * Usage:
+ *      abp_chain_parameters parameters;
+ *      parameters.timeout_ms = 30000;
+ *      abp_chain_solution solution = solve_abp_chain(parameters);
+ *      solution.mean_delay_ms, solution.tail(100000), ...
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+#ifndef __ABP_MARKOV_HPP_
+#define __ABP_MARKOV_HPP_
+
+#include <string>
+#include <map>
+
+using namespace std;
+
+/**
+ * Parameters of the chain, the defaults are the ones of the models
+ */
+struct abp_chain_parameters{
+    long long sender_preparation_ms = 10000;
+    long long timeout_ms = 20000;
+    long long receiver_preparation_ms = 10000;
+    double loss = 0.05;                       /**< Loss probability of each subnet */
+    map<long long, double> link_delay_ms = {{3000, 1.0}};  /**< Distribution of the delay of a subnet */
+};
+
+/**
+ * Solution of the chain
+ */
+struct abp_chain_solution{
+    bool applicable = false;
+    string reason;                     /**< Why the chain doesn't apply, empty if it does */
+    double success = 0;                /**< Probability that an attempt is acked */
+    double mean_transmissions = 0;     /**< E[K + 1] */
+    double mean_delay_ms = 0;
+    double delay_std_ms = 0;
+    double throughput_per_hour = 0;    /**< Packets acked per hour by a sender never idle */
+    map<long long, double> delay_pmf;  /**< Distribution of the delay, up to the truncated tail */
+    double truncated = 0;              /**< Probability of the delays left out of delay_pmf */
+
+    /**
+     * @brief      Probability that the delay exceeds a time
+     */
+    double tail(long long) const;
+
+    /**
+     * @brief      Smallest delay whose cumulative probability reaches p
+     */
+    long long quantile(double) const;
+};
+
+/**
+ * @brief      Solves the chain of a packet
+ *
+ * @param[in]  parameters  parameters of the models
+ * @param[in]  tail_mass   probability of the delays left out of the distribution
+ * @return     The solution, applicable is false if the parameters leave the chain
+ */
+abp_chain_solution solve_abp_chain(const abp_chain_parameters &, double tail_mass = 1e-12);
+
+#endif /**< __ABP_MARKOV_HPP_ */
@@ -0,0 +1,178 @@
+/** \brief Parameters of the senders, receivers and subnets of a run
+ *
+ * abp_parameters gathers what a run can change on the models of the ABP
+ * simulator. The simulation service, the replications and the test driver
+ * take them in the same key=value form (abp_set_parameter), check them with
+ * abp_check_parameters and set them on the models with abp_configure.
+ * The link trace of the subnets is mapped and offset per pair by abp_runner.
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#ifndef __ABP_PARAMETERS_HPP__
+#define __ABP_PARAMETERS_HPP__
+
+#include <string>
+#include <cstdlib>
+
+#include "data_structures/bag_policy.hpp"
+#include "sender_cadmium.hpp"
+#include "receiver_cadmium.hpp"
+#include "subnet_cadmium.hpp"
+#include "link_trace.hpp"
+
+/**
+ * Parameters of a run, the defaults are the ones of the models
+ */
+template<typename TIME>
+struct abp_parameters{
+    TIME sender_preparation = TIME("00:00:10");
+    TIME sender_timeout = TIME("00:00:20");
+    TIME receiver_preparation = TIME("00:00:10");
+    TIME receiver_ack_delay = TIME("00:00:00");  /**< Acknowledgements held at most this long, see Receiver */
+    int receiver_ack_every = 1;                  /**< Held packets releasing an acknowledgement */
+    bool nak = false;         /**< Lost messages arrive damaged, are NAKed and retransmitted at once */
+    bool overlap_preparation = false; /**< Senders prepare the next packet while waiting for an ack */
+    bool queue_requests = false; /**< Senders queue the requests arriving during a transfer */
+    bag_policy bags = bag_policy::in_order; /**< Bags of several messages of the senders, receivers and subnets */
+    std::string link_trace;   /**< Recorded link trace replayed by the subnets, empty to draw the losses */
+    long long trace_offset = 0;         /**< Records, or milliseconds, of the trace skipped by subnet1 */
+    long long trace_reverse_offset = 0; /**< Same for subnet2, the reverse link */
+    long long trace_stride = 0;         /**< Added to both offsets for every pair after the first */
+    bool trace_loop = false;            /**< The subnets start the trace again at its end */
+    unsigned int seed = 0;    /**< Replication seed, 0 keeps the seeds of the topology */
+};
+
+/**
+ * @brief      Whether a parameter value is a time HH:MM:SS:mmm
+ */
+inline bool abp_parameter_time(const std::string &value) {
+    int fields = 1;
+    bool digit_seen = false;
+    for (char c : value) {
+        if (c >= '0' && c <= '9') {
+            digit_seen = true;
+        }else if (c == ':' && digit_seen) {
+            ++fields;
+            digit_seen = false;
+        }else {
+            return false;
+        }
+    }
+    return fields == 4 && digit_seen;
+}
+
+/**
+ * @brief      Sets a parameter of a run from its key=value form
+ * The simulation service and the replications take the same keys: timeout, preparation,
+ * ack_preparation and ack_delay (HH:MM:SS:mmm), ack_every, nak, overlap, queue and
+ * trace_loop (0 or 1), bags, link_trace (opened to check it), trace_offset,
+ * trace_reverse_offset, trace_stride and seed.
+ * @return     empty if the parameter is valid, otherwise the error message
+ */
+template<typename TIME>
+std::string abp_set_parameter(const std::string &key, const std::string &value, abp_parameters<TIME> &parameters) {
+    std::string invalid = "invalid " + key + " " + value;
+    if (key == "nak" || key == "overlap" || key == "queue" || key == "trace_loop") {
+        if (value != "0" && value != "1") {
+            return invalid;
+        }
+        (key == "nak" ? parameters.nak : key == "overlap" ? parameters.overlap_preparation
+            : key == "queue" ? parameters.queue_requests : parameters.trace_loop) = (value == "1");
+        return "";
+    }
+    if (key == "link_trace") {
+        link_trace trace(value);
+        if (!trace.is_open()) {
+            return trace.error();
+        }
+        parameters.link_trace = value;
+        return "";
+    }
+    if (key == "bags") {
+        return parse_bag_policy(value, parameters.bags) ? "" : invalid;
+    }
+    if (key == "trace_offset" || key == "trace_reverse_offset" || key == "trace_stride"
+            || key == "ack_every" || key == "seed") {
+        char *end = nullptr;
+        long long number = strtoll(value.c_str(), &end, 10);
+        if (value.empty() || *end != '\0' || number < 0) {
+            return invalid;
+        }
+        if (key == "ack_every") {
+            if (number < 1 || number > 1000000) {
+                return invalid;
+            }
+            parameters.receiver_ack_every = (int) number;
+        }else if (key == "seed") {
+            parameters.seed = (unsigned int) number;
+        }else {
+            (key == "trace_offset" ? parameters.trace_offset : key == "trace_stride"
+                ? parameters.trace_stride : parameters.trace_reverse_offset) = number;
+        }
+        return "";
+    }
+    if (key == "timeout" || key == "preparation" || key == "ack_preparation" || key == "ack_delay") {
+        if (!abp_parameter_time(value)) {
+            return invalid;
+        }
+        (key == "timeout" ? parameters.sender_timeout : key == "preparation" ? parameters.sender_preparation
+            : key == "ack_preparation" ? parameters.receiver_preparation : parameters.receiver_ack_delay)
+            = TIME(value.c_str());
+        return "";
+    }
+    return "unknown parameter " + key;
+}
+
+/**
+ * @brief      Checks the parameters against each other
+ * A receiver holding its acknowledgements for ACK_EVERY packets needs an ACK_DELAY
+ * bounding the hold, otherwise the last packets of a transfer are never acknowledged.
+ * @return     empty if the parameters are consistent, otherwise the error message
+ */
+template<typename TIME>
+std::string abp_check_parameters(const abp_parameters<TIME> &parameters) {
+    if (parameters.receiver_ack_every > 1 && parameters.receiver_ack_delay == TIME()) {
+        return "ack_every " + std::to_string(parameters.receiver_ack_every) + " needs an ack_delay";
+    }
+    return "";
+}
+
+/**
+ * @brief      Sets the parameters of a run on a sender
+ */
+template<typename TIME>
+void abp_configure(Sender<TIME> &sender, const abp_parameters<TIME> &parameters) {
+    sender.PREPARATION_TIME = parameters.sender_preparation;
+    sender.timeout = parameters.sender_timeout;
+    sender.nak_recovery = parameters.nak;
+    sender.overlap_preparation = parameters.overlap_preparation;
+    sender.queue_requests = parameters.queue_requests;
+    sender.bag_handling = parameters.bags;
+}
+
+/**
+ * @brief      Sets the parameters of a run on a receiver
+ */
+template<typename TIME>
+void abp_configure(Receiver<TIME> &receiver, const abp_parameters<TIME> &parameters) {
+    receiver.PREPARATION_TIME = parameters.receiver_preparation;
+    receiver.ACK_DELAY = parameters.receiver_ack_delay;
+    receiver.ACK_EVERY = parameters.receiver_ack_every;
+    receiver.NAK = parameters.nak;
+    receiver.BAG_HANDLING = parameters.bags;
+}
+
+/**
+ * @brief      Sets the parameters of a run on a subnet, but its link trace
+ */
+template<typename TIME>
+void abp_configure(Subnet<TIME> &subnet, const abp_parameters<TIME> &parameters) {
+    subnet.DAMAGE_ON_LOSS = parameters.nak;
+    subnet.BAG_HANDLING = parameters.bags;
+}
+
+#endif // __ABP_PARAMETERS_HPP__
@@ -0,0 +1,178 @@
+/** \brief Reusable runner of the ABP simulator for back-to-back scenarios
+ *
+ * Building the simulator allocates every model, bag and route. abp_runner
+ * builds the pairs of make_abp_pairs_flat (or the single simulator of
+ * make_abp_flat) on a flat kernel once, on its first run. Every later run
+ * re-arms the built topology: the models are reset (reset_abp_flat), the
+ * generator restarts on the control input of the run and the parameters of the
+ * run are set on the senders and receivers. A run of a re-armed runner writes
+ * the same trace as a runner just built. A run given a replication seed draws the
+ * losses of its subnets from the streams of that seed (abp_replication_seed).
+ * A run given a link trace replays it on its subnets instead (link_trace.hpp), the
+ * traces are mapped once and kept by the runner for its next runs.
+ *
+ * Usage:
+ *      abp_runner<NDTime> runner;
+ *      abp_parameters<NDTime> parameters;
+ *      parameters.sender_timeout = NDTime("00:00:30:000");
+ *      for (...) {
+ *          ostringstream trace;
+ *          runner.run(input_file, NDTime("04:00:00:000"), &trace, parameters);
+ *      }
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#ifndef __ABP_RUNNER_HPP__
+#define __ABP_RUNNER_HPP__
+
+#include <iostream>
+#include <string>
+#include <map>
+#include <memory>
+#include <stdexcept>
+
+#include "abp_topology.hpp"
+#include "flat_kernel.hpp"
+#include "link_trace.hpp"
+#include "abp_parameters.hpp"
+
+/**
+ * @brief      Class running scenarios back to back on one built topology
+ */
+template<typename TIME>
+class abp_runner{
+    flat_kernel<TIME> kernel;
+    int pairs;
+    bool built = false;
+    long long run_count = 0;
+    std::map<std::string, std::shared_ptr<const link_trace>> traces; /**< Traces mapped by the runs */
+
+    /**
+     * @brief      Trace of a path, mapped by its first run
+     * @throws     std::invalid_argument if it can't be read
+     */
+    std::shared_ptr<const link_trace> trace_of(const std::string &path) {
+        auto found = traces.find(path);
+        if (found != traces.end()) {
+            return found->second;
+        }
+        std::shared_ptr<const link_trace> trace = std::make_shared<link_trace>(path);
+        if (!trace->is_open()) {
+            throw std::invalid_argument(trace->error());
+        }
+        traces[path] = trace;
+        return trace;
+    }
+
+    public:
+        /**
+         * @param[in]  i_pairs  number of pairs, 1 for the single simulator of main.cpp
+         */
+        abp_runner(int i_pairs = 1) : pairs(i_pairs) {}
+
+        /**
+         * @brief      Runs a scenario
+         *
+         * @param[in]  input_data_control  control input file of the scenario
+         * @param[in]  end                 end time of the run
+         * @param[out] trace               stream receiving the trace, nullptr for none
+         * @param[in]  parameters          parameters of the senders and receivers
+         * @return     Time of the next event
+         * @throws     std::invalid_argument if the parameters are inconsistent (abp_check_parameters)
+         *             or the link trace of the parameters can't be read
+         */
+        TIME run(const char * input_data_control, const TIME &end, std::ostream *trace = nullptr,
+                 const abp_parameters<TIME> &parameters = abp_parameters<TIME>()) {
+            std::string inconsistent = abp_check_parameters(parameters);
+            if (!inconsistent.empty()) {
+                throw std::invalid_argument(inconsistent);
+            }
+            std::shared_ptr<const link_trace> replayed;
+            if (!parameters.link_trace.empty()) {
+                replayed = trace_of(parameters.link_trace);
+            }
+            /** The single simulator is pair 0, the pairs of make_abp_pairs_flat are 1..pairs */
+            int first = (pairs == 1) ? 0 : 1;
+            int last = (pairs == 1) ? 0 : pairs;
+            if (!built) {
+                if (pairs == 1) {
+                    make_abp_flat(kernel, input_data_control);
+                }else {
+                    make_abp_pairs_flat(kernel, input_data_control, 1, pairs);
+                }
+                built = true;
+            }else {
+                for (int k = first; k <= last; k++) {
+                    reset_abp_flat(kernel, input_data_control, k);
+                }
+            }
+            for (int k = first; k <= last; k++) {
+                std::string suffix = (k == 0) ? "" : "_" + std::to_string(k);
+                abp_configure(kernel.template model<Sender>("sender1" + suffix), parameters);
+                abp_configure(kernel.template model<Receiver>("receiver1" + suffix), parameters);
+                for (int link = 1; link <= 2; link++) {
+                    Subnet<TIME> &subnet = kernel.template model<Subnet>("subnet" + std::to_string(link) + suffix);
+                    abp_configure(subnet, parameters);
+                    subnet.LINK_TRACE = replayed;
+                    subnet.TRACE_OFFSET = ((link == 1) ? parameters.trace_offset : parameters.trace_reverse_offset)
+                                          + (k - first) * parameters.trace_stride;
+                    subnet.TRACE_LOOP = parameters.trace_loop;
+                }
+                if (parameters.seed != 0) {
+                    kernel.template model<Subnet>("subnet1" + suffix).reset(abp_replication_seed(parameters.seed, k, 0));
+                    kernel.template model<Subnet>("subnet2" + suffix).reset(abp_replication_seed(parameters.seed, k, 1));
+                }
+            }
+            if (trace != nullptr) {
+                kernel.reset(*trace);
+            }else {
+                kernel.reset();
+            }
+            run_count++;
+            return kernel.run_until(end);
+        }
+
+        /** Number of pairs of the topology */
+        int pair_count() const {
+            return pairs;
+        }
+
+        /** Number of runs made, the topology was built by the first one */
+        long long runs() const {
+            return run_count;
+        }
+
+        /** Steps of the last run */
+        long long steps() const {
+            return kernel.steps();
+        }
+
+        /** Transitions of the last run */
+        long long transitions() const {
+            return kernel.transitions();
+        }
+
+        /**
+         * Messages of bags dropped by the senders, receivers and subnets in the last run (bag_policy::drop),
+         * and packets of bags the subnets overwrote with a later one (bag_policy::in_order)
+         */
+        long bag_drops() {
+            long dropped = 0;
+            int first = (pairs == 1) ? 0 : 1;
+            int last = (pairs == 1) ? 0 : pairs;
+            for (int k = first; built && k <= last; k++) {
+                std::string suffix = (k == 0) ? "" : "_" + std::to_string(k);
+                dropped += kernel.template model<Sender>("sender1" + suffix).state.dropped
+                           + kernel.template model<Receiver>("receiver1" + suffix).state.dropped
+                           + kernel.template model<Subnet>("subnet1" + suffix).state.dropped
+                           + kernel.template model<Subnet>("subnet2" + suffix).state.dropped;
+            }
+            return dropped;
+        }
+};
+
+#endif // __ABP_RUNNER_HPP__
@@ -0,0 +1,452 @@
+/** \brief Topologies of the ABP simulator built from the atomic models
+ *
+ * The functions of this header build the coupled models run by the simulator
+ * binaries, so each topology is written once. The model ids are the ones found
+ * in the traces (sender1, receiver1, subnet1, ...).
+ *
+ *      - make_abp_top: the ABP simulator of main.cpp, generator_con feeding
+ *        ABPSimulator{sender1, receiver1, Network{subnet1, subnet2}}
+ *      - make_abp_pairs_top: independent copies of it, one per pair, used by
+ *        the parallel runner (see parallel_runner.hpp)
+ *      - make_shared_link_top: M sender/receiver pairs sharing one queued
+ *        link in each direction (see mux_cadmium.hpp)
+ *      - make_abp_flat, make_abp_pairs_flat: the same models as make_abp_top
+ *        and make_abp_pairs_top for the flat kernel (see flat_kernel.hpp)
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#ifndef __ABP_TOPOLOGY_HPP__
+#define __ABP_TOPOLOGY_HPP__
+
+#include <string>
+#include <memory>
+#include <stdint.h>
+
+#include <cadmium/modeling/coupling.hpp>
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/dynamic_model_translator.hpp>
+#include <cadmium/concept/coupled_model_assert.hpp>
+#include <cadmium/modeling/dynamic_coupled.hpp>
+#include <cadmium/modeling/dynamic_atomic.hpp>
+
+#include "../lib/vendor/iestream.hpp"
+
+#include "data_structures/message.hpp"
+#include "sender_cadmium.hpp"
+#include "receiver_cadmium.hpp"
+#include "subnet_cadmium.hpp"
+#include "mux_cadmium.hpp"
+#include "flat_kernel.hpp"
+
+/**
+ * Application generator, it plays the control input file of the simulation.
+ * @tParam message T
+ */
+template<typename T>
+class ApplicationGen : public iestream_input<message_t,T>{
+    public:
+    ApplicationGen() = default;
+    /**
+     * For class application generator , a parameterized constructor created.
+     * It takes input path of the file that has the input for ruuning the application.
+     * @param file_path
+     */
+    ApplicationGen(const char* file_path) : iestream_input<message_t,T>(file_path), input_file(file_path) {}
+
+    /**
+     * Restarts the generator on another control input, as if it was just built with it.
+     * The parser is replaced so the stream of the previous input is closed.
+     * @param file_path
+     */
+    void reset(const char* file_path) {
+        this->state._parser = Parser<T, message_t>(file_path);
+        this->state._next_input.clear();
+        this->state._simulation_time = T();
+        this->state._next_time = T();
+        this->state._next_time2 = T();
+        this->state._initialization = true;
+        input_file = file_path;
+        transitions = 0;
+    }
+
+    /**
+     * Internal transition of iestream_input, counted so the generator can be restored
+     */
+    void internal_transition() {
+        iestream_input<message_t,T>::internal_transition();
+        transitions++;
+    }
+
+    /**
+     * The state holds the stream of the control input, which can't be copied. A checkpoint
+     * is the input and the number of internal transitions made, restoring it replays them
+     * on the input (see flat_kernel::save).
+     */
+    struct checkpoint_type{
+        std::string input_file;
+        long long transitions;
+    };
+
+    checkpoint_type checkpoint() const {
+        return checkpoint_type{input_file, transitions};
+    }
+
+    void restore(const checkpoint_type &saved) {
+        reset(saved.input_file.c_str());
+        while (transitions < saved.transitions) {
+            internal_transition();
+        }
+    }
+
+    private:
+    std::string input_file;
+    long long transitions = 0;
+
+};
+
+/**
+ * Setting input ports for messages
+ */
+struct inp_control : public cadmium::in_port<message_t> {};
+struct inp_1 : public cadmium::in_port<message_t> {};
+struct inp_2 : public cadmium::in_port<message_t> {};
+
+/**
+ * Setting output ports for messages
+ */
+struct outp_ack : public cadmium::out_port<message_t> {};
+struct outp_1 : public cadmium::out_port<message_t> {};
+struct outp_2 : public cadmium::out_port<message_t> {};
+struct outp_pack : public cadmium::out_port<message_t> {};
+
+/**
+ * Seed of the loss stream of subnet1 of a pair, subnet2 uses the next one
+ */
+inline unsigned int abp_subnet_seed(int pair) {
+    return (pair == 0) ? 1u : 2u * pair - 1u;
+}
+
+/**
+ * @brief      Seed of the loss stream of a subnet in a replication
+ *
+ * Replications of a scenario draw their losses from the streams of a replication
+ * seed instead of the fixed seeds of abp_subnet_seed. The seed, the pair and the
+ * link are mixed (splitmix64 finalizer), so neighbouring replications and the two
+ * subnets of a pair get unrelated streams. Two runs with the same replication seed
+ * lose the same draws, which is what common random numbers rely on.
+ *
+ * @param[in]  seed  seed of the replication
+ * @param[in]  pair  number of the pair, 0 for the single simulator
+ * @param[in]  link  0 for subnet1, 1 for subnet2
+ * @return     Seed of the stream, between 1 and 2^31 - 2
+ */
+inline unsigned int abp_replication_seed(unsigned int seed, int pair, int link) {
+    uint64_t z = ((uint64_t) seed << 32) + 2u * (uint64_t) pair + (uint64_t) link + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    z ^= z >> 31;
+    return (unsigned int) (z % 2147483646u) + 1u;
+}
+
+/**
+ * @brief      Builds the ABP simulator
+ *
+ * Pair 0 is the model of main.cpp: the coupled model is TOP and the ids are the
+ * ones of the original traces (generator_con, sender1, receiver1, subnet1,
+ * subnet2, Network, ABPSimulator). Pair k > 0 is a copy of it named ABP_k whose
+ * ids end with _k (sender1_k, subnet1_k, ...), so several pairs can be coupled in
+ * one model. Its subnets draw their losses from seeds 2k-1 and 2k, pair 1 has the
+ * seeds of pair 0.
+ *
+ * @param[in]  input_data_control  control input file
+ * @param[in]  pair                number of the pair, 0 for the single simulator
+ * @return     The coupled model of the pair
+ */
+template<typename TIME>
+std::shared_ptr<cadmium::dynamic::modeling::coupled<TIME>> make_abp_top(const char * input_data_control,
+                                                                         int pair = 0) {
+    using namespace cadmium::dynamic::translate;
+    std::string suffix = (pair == 0) ? "" : "_" + std::to_string(pair);
+    unsigned int seed = abp_subnet_seed(pair);
+    std::string generator_id = "generator_con" + suffix;
+    std::string sender_id = "sender1" + suffix;
+    std::string receiver_id = "receiver1" + suffix;
+    std::string subnet1_id = "subnet1" + suffix;
+    std::string subnet2_id = "subnet2" + suffix;
+    std::string network_id = "Network" + suffix;
+    std::string simulator_id = "ABPSimulator" + suffix;
+
+    /**
+     * The generator plays the control input file, the sender and the receiver
+     * exchange the packets and acknowledgements through the two subnets.
+     */
+    std::shared_ptr<cadmium::dynamic::modeling::model> generator_con =
+        make_dynamic_atomic_model<ApplicationGen, TIME, const char* >(generator_id, std::move(input_data_control));
+    std::shared_ptr<cadmium::dynamic::modeling::model> sender1 =
+        make_dynamic_atomic_model<Sender, TIME>(sender_id);
+    std::shared_ptr<cadmium::dynamic::modeling::model> receiver1 =
+        make_dynamic_atomic_model<Receiver, TIME>(receiver_id);
+    std::shared_ptr<cadmium::dynamic::modeling::model> subnet1 =
+        make_dynamic_atomic_model<Subnet, TIME, unsigned int>(subnet1_id, std::move(seed));
+    unsigned int seed2 = seed + 1u;
+    std::shared_ptr<cadmium::dynamic::modeling::model> subnet2 =
+        make_dynamic_atomic_model<Subnet, TIME, unsigned int>(subnet2_id, std::move(seed2));
+
+    /** Network: the link in each direction */
+    cadmium::dynamic::modeling::Ports iports_Network = {typeid(inp_1),typeid(inp_2)};
+    cadmium::dynamic::modeling::Ports oports_Network = {typeid(outp_1),typeid(outp_2)};
+    cadmium::dynamic::modeling::Models submodels_Network = {subnet1, subnet2};
+    cadmium::dynamic::modeling::EICs eics_Network = {
+        make_EIC<inp_1, subnet_defs::in>(subnet1_id),
+        make_EIC<inp_2, subnet_defs::in>(subnet2_id)
+    };
+    cadmium::dynamic::modeling::EOCs eocs_Network = {
+        make_EOC<subnet_defs::out,outp_1>(subnet1_id),
+        make_EOC<subnet_defs::out,outp_2>(subnet2_id)
+    };
+    cadmium::dynamic::modeling::ICs ics_Network = {};
+    std::shared_ptr<cadmium::dynamic::modeling::coupled<TIME>> NETWORK =
+        std::make_shared<cadmium::dynamic::modeling::coupled<TIME>>(network_id,
+                                                                    submodels_Network,
+                                                                    iports_Network,
+                                                                    oports_Network,
+                                                                    eics_Network,
+                                                                    eocs_Network,
+                                                                    ics_Network);
+
+    /** ABPSimulator: the sender and the receiver connected by the Network */
+    cadmium::dynamic::modeling::Ports iports_ABPSimulator = {typeid(inp_control)};
+    cadmium::dynamic::modeling::Ports oports_ABPSimulator = {typeid(outp_ack),typeid(outp_pack)};
+    cadmium::dynamic::modeling::Models submodels_ABPSimulator = {sender1, receiver1, NETWORK};
+    cadmium::dynamic::modeling::EICs eics_ABPSimulator = {
+        make_EIC<inp_control, sender_defs::controlIn>(sender_id)
+    };
+    cadmium::dynamic::modeling::EOCs eocs_ABPSimulator = {
+        make_EOC<sender_defs::packetSentOut,outp_pack>(sender_id),
+        make_EOC<sender_defs::ackReceivedOut,outp_ack>(sender_id)
+    };
+    cadmium::dynamic::modeling::ICs ics_ABPSimulator = {
+        make_IC<sender_defs::dataOut, inp_1>(sender_id, network_id),
+        make_IC<outp_2, sender_defs::ackIn>(network_id, sender_id),
+        make_IC<receiver_defs::out, inp_2>(receiver_id, network_id),
+        make_IC<outp_1, receiver_defs::in>(network_id, receiver_id)
+    };
+    std::shared_ptr<cadmium::dynamic::modeling::coupled<TIME>> ABPSimulator =
+        std::make_shared<cadmium::dynamic::modeling::coupled<TIME>>(simulator_id,
+                                                                    submodels_ABPSimulator,
+                                                                    iports_ABPSimulator,
+                                                                    oports_ABPSimulator,
+                                                                    eics_ABPSimulator,
+                                                                    eocs_ABPSimulator,
+                                                                    ics_ABPSimulator);
+
+    /** TOP: the generator driving the ABPSimulator */
+    cadmium::dynamic::modeling::Ports iports_TOP = {};
+    cadmium::dynamic::modeling::Ports oports_TOP = {typeid(outp_pack),typeid(outp_ack)};
+    cadmium::dynamic::modeling::Models submodels_TOP = {generator_con, ABPSimulator};
+    cadmium::dynamic::modeling::EICs eics_TOP = {};
+    cadmium::dynamic::modeling::EOCs eocs_TOP = {
+        make_EOC<outp_pack,outp_pack>(simulator_id),
+        make_EOC<outp_pack,outp_ack>(simulator_id)
+    };
+    cadmium::dynamic::modeling::ICs ics_TOP = {
+        make_IC<iestream_input_defs<message_t>::out,inp_control>(generator_id, simulator_id)
+    };
+    return std::make_shared<cadmium::dynamic::modeling::coupled<TIME>>((pair == 0) ? "TOP" : "ABP" + suffix,
+                                                                       submodels_TOP,
+                                                                       iports_TOP,
+                                                                       oports_TOP,
+                                                                       eics_TOP,
+                                                                       eocs_TOP,
+                                                                       ics_TOP);
+}
+
+/**
+ * @brief      Builds a TOP model holding the pairs first..last of make_abp_top
+ *
+ * The pairs aren't coupled with each other. Running the pairs 1..M in one TOP or
+ * splitting them into contiguous ranges run side by side gives the same trace
+ * once merged (see parallel_runner.hpp).
+ *
+ * @param[in]  input_data_control  control input file played by every pair
+ * @param[in]  first, last         range of pairs, both included
+ * @return     The TOP coupled model
+ */
+template<typename TIME>
+std::shared_ptr<cadmium::dynamic::modeling::coupled<TIME>> make_abp_pairs_top(const char * input_data_control,
+                                                                               int first, int last) {
+    cadmium::dynamic::modeling::Models submodels_TOP;
+    for (int k = first; k <= last; k++) {
+        submodels_TOP.push_back(make_abp_top<TIME>(input_data_control, k));
+    }
+    cadmium::dynamic::modeling::Ports iports_TOP = {};
+    cadmium::dynamic::modeling::Ports oports_TOP = {};
+    cadmium::dynamic::modeling::EICs eics_TOP = {};
+    cadmium::dynamic::modeling::EOCs eocs_TOP = {};
+    cadmium::dynamic::modeling::ICs ics_TOP = {};
+    return std::make_shared<cadmium::dynamic::modeling::coupled<TIME>>("TOP",
+                                                                       submodels_TOP,
+                                                                       iports_TOP,
+                                                                       oports_TOP,
+                                                                       eics_TOP,
+                                                                       eocs_TOP,
+                                                                       ics_TOP);
+}
+
+/**
+ * @brief      Adds the ABP simulator of make_abp_top to a flat kernel
+ *
+ * The models, their ids, their order and the seeds of the subnets are the ones of
+ * make_abp_top, so both backends write the same trace. The couplings through
+ * ABPSimulator and Network become direct routes between the atomics.
+ *
+ * @param[in]  kernel              kernel receiving the models
+ * @param[in]  input_data_control  control input file
+ * @param[in]  pair                number of the pair, 0 for the single simulator
+ * @param[in]  parent              coupled model holding the pair, -1 for none
+ */
+template<typename TIME>
+void make_abp_flat(flat_kernel<TIME> &kernel, const char * input_data_control, int pair = 0, int parent = -1) {
+    std::string suffix = (pair == 0) ? "" : "_" + std::to_string(pair);
+    unsigned int seed = abp_subnet_seed(pair);
+    std::string generator_id = "generator_con" + suffix;
+    std::string sender_id = "sender1" + suffix;
+    std::string receiver_id = "receiver1" + suffix;
+    std::string subnet1_id = "subnet1" + suffix;
+    std::string subnet2_id = "subnet2" + suffix;
+
+    int top = kernel.add_coupled((pair == 0) ? "TOP" : "ABP" + suffix, parent);
+    kernel.template add_atomic<ApplicationGen>(generator_id, top, input_data_control);
+    int simulator = kernel.add_coupled("ABPSimulator" + suffix, top);
+    kernel.template add_atomic<Sender>(sender_id, simulator);
+    kernel.template add_atomic<Receiver>(receiver_id, simulator);
+    int network = kernel.add_coupled("Network" + suffix, simulator);
+    kernel.template add_atomic<Subnet>(subnet1_id, network, seed);
+    kernel.template add_atomic<Subnet>(subnet2_id, network, seed + 1u);
+
+    kernel.template connect<iestream_input_defs<message_t>::out, sender_defs::controlIn>(generator_id, sender_id);
+    kernel.template connect<sender_defs::dataOut, subnet_defs::in>(sender_id, subnet1_id);
+    kernel.template connect<subnet_defs::out, receiver_defs::in>(subnet1_id, receiver_id);
+    kernel.template connect<receiver_defs::out, subnet_defs::in>(receiver_id, subnet2_id);
+    kernel.template connect<subnet_defs::out, sender_defs::ackIn>(subnet2_id, sender_id);
+}
+
+/**
+ * @brief      Adds the pairs first..last of make_abp_pairs_top to a flat kernel
+ */
+template<typename TIME>
+void make_abp_pairs_flat(flat_kernel<TIME> &kernel, const char * input_data_control, int first, int last) {
+    int top = kernel.add_coupled("TOP");
+    for (int k = first; k <= last; k++) {
+        make_abp_flat(kernel, input_data_control, k, top);
+    }
+}
+
+/**
+ * @brief      Puts the models of make_abp_flat back in their initial state
+ *
+ * The generator restarts on another control input and the subnets restart their
+ * loss streams from their seeds, so with kernel.reset() the next run is the one
+ * of a kernel just built with make_abp_flat. The parameters of the sender and the
+ * receiver are kept.
+ *
+ * @param[in]  kernel              kernel holding the models
+ * @param[in]  input_data_control  control input file of the next run
+ * @param[in]  pair                number of the pair, 0 for the single simulator
+ */
+template<typename TIME>
+void reset_abp_flat(flat_kernel<TIME> &kernel, const char * input_data_control, int pair = 0) {
+    std::string suffix = (pair == 0) ? "" : "_" + std::to_string(pair);
+    unsigned int seed = abp_subnet_seed(pair);
+    kernel.template model<ApplicationGen>("generator_con" + suffix).reset(input_data_control);
+    kernel.template model<Sender>("sender1" + suffix).reset();
+    kernel.template model<Receiver>("receiver1" + suffix).reset();
+    kernel.template model<Subnet>("subnet1" + suffix).reset(seed);
+    kernel.template model<Subnet>("subnet2" + suffix).reset(seed + 1u);
+}
+
+/**
+ * @brief      Puts the pairs first..last of make_abp_pairs_flat back in their initial state
+ */
+template<typename TIME>
+void reset_abp_pairs_flat(flat_kernel<TIME> &kernel, const char * input_data_control, int first, int last) {
+    for (int k = first; k <= last; k++) {
+        reset_abp_flat(kernel, input_data_control, k);
+    }
+}
+
+/**
+ * Output ports of the shared link TOP model
+ */
+struct shared_outp_pack : public cadmium::out_port<message_t> {};
+struct shared_outp_ack : public cadmium::out_port<message_t> {};
+
+/**
+ * @brief      Builds M sender/receiver pairs sharing one link in each direction
+ *
+ * One generator (generator_con) sends the control input to every sender, so all
+ * flows contend for the link from the start. Flow k is made of senderk and
+ * receiverk. The forward link is mux1 -> subnet1 -> demux1_k and the reverse
+ * link mux2 -> subnet2 -> demux2_k.
+ *
+ * @param[in]  flows               number of sender/receiver pairs (M)
+ * @param[in]  input_data_control  control input file
+ * @return     The TOP coupled model
+ */
+template<typename TIME>
+std::shared_ptr<cadmium::dynamic::modeling::coupled<TIME>> make_shared_link_top(int flows,
+                                                                                 const char * input_data_control) {
+    using namespace cadmium::dynamic::translate;
+    cadmium::dynamic::modeling::Models submodels_TOP;
+    cadmium::dynamic::modeling::EOCs eocs_TOP;
+    cadmium::dynamic::modeling::ICs ics_TOP;
+
+    submodels_TOP.push_back(make_dynamic_atomic_model<ApplicationGen, TIME, const char* >("generator_con",
+                                                                                           std::move(input_data_control)));
+    for (int k = 1; k <= flows; k++) {
+        std::string flow = std::to_string(k);
+        submodels_TOP.push_back(make_dynamic_atomic_model<Sender, TIME, int>("sender" + flow, std::move(k)));
+        submodels_TOP.push_back(make_dynamic_atomic_model<Receiver, TIME>("receiver" + flow));
+    }
+    submodels_TOP.push_back(make_dynamic_atomic_model<Mux, TIME>("mux1"));
+    submodels_TOP.push_back(make_dynamic_atomic_model<Subnet, TIME, unsigned int>("subnet1", 1u));
+    submodels_TOP.push_back(make_dynamic_atomic_model<Mux, TIME>("mux2"));
+    submodels_TOP.push_back(make_dynamic_atomic_model<Subnet, TIME, unsigned int>("subnet2", 2u));
+    for (int k = 1; k <= flows; k++) {
+        std::string flow = std::to_string(k);
+        submodels_TOP.push_back(make_dynamic_atomic_model<Demux, TIME, int>("demux1_" + flow, std::move(k)));
+        submodels_TOP.push_back(make_dynamic_atomic_model<Demux, TIME, int>("demux2_" + flow, std::move(k)));
+    }
+
+    ics_TOP.push_back(make_IC<mux_defs::out, subnet_defs::in>("mux1", "subnet1"));
+    ics_TOP.push_back(make_IC<mux_defs::out, subnet_defs::in>("mux2", "subnet2"));
+    for (int k = 1; k <= flows; k++) {
+        std::string flow = std::to_string(k);
+        ics_TOP.push_back(make_IC<iestream_input_defs<message_t>::out, sender_defs::controlIn>("generator_con", "sender" + flow));
+        ics_TOP.push_back(make_IC<sender_defs::dataOut, mux_defs::in>("sender" + flow, "mux1"));
+        ics_TOP.push_back(make_IC<subnet_defs::out, demux_defs::in>("subnet1", "demux1_" + flow));
+        ics_TOP.push_back(make_IC<demux_defs::out, receiver_defs::in>("demux1_" + flow, "receiver" + flow));
+        ics_TOP.push_back(make_IC<receiver_defs::out, mux_defs::in>("receiver" + flow, "mux2"));
+        ics_TOP.push_back(make_IC<subnet_defs::out, demux_defs::in>("subnet2", "demux2_" + flow));
+        ics_TOP.push_back(make_IC<demux_defs::out, sender_defs::ackIn>("demux2_" + flow, "sender" + flow));
+        eocs_TOP.push_back(make_EOC<sender_defs::packetSentOut, shared_outp_pack>("sender" + flow));
+        eocs_TOP.push_back(make_EOC<sender_defs::ackReceivedOut, shared_outp_ack>("sender" + flow));
+    }
+
+    cadmium::dynamic::modeling::Ports iports_TOP = {};
+    cadmium::dynamic::modeling::Ports oports_TOP = {typeid(shared_outp_pack), typeid(shared_outp_ack)};
+    cadmium::dynamic::modeling::EICs eics_TOP = {};
+    return std::make_shared<cadmium::dynamic::modeling::coupled<TIME>>("TOP",
+                                                                       submodels_TOP,
+                                                                       iports_TOP,
+                                                                       oports_TOP,
+                                                                       eics_TOP,
+                                                                       eocs_TOP,
+                                                                       ics_TOP);
+}
+
+#endif // __ABP_TOPOLOGY_HPP__
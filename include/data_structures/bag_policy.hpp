@@ -0,0 +1,75 @@
+/** \brief header file defining how the models take bags of several messages
+ *
+ * A bag holds every message arriving on a port at the same time. The Sender,
+ * Receiver and Subnet handle one message at a time, a bag of several messages
+ * (bursts of the control input, several flows on a link) is taken following
+ * their bag policy:
+ *      - in_order: every message is taken, in bag order, as if they arrived one
+ *        after the other with no time in between. A Subnet only keeps the last
+ *        packet in transit, the ones before are counted as dropped
+ *      - queue: the first message is taken, the others wait in the model and one
+ *        of them is taken at the end of each of its next internal transitions,
+ *        or at once while the model is passive (it has no next transition)
+ *      - drop: the first message is taken, the others are dropped and counted
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#ifndef __BAG_POLICY_HPP__
+#define __BAG_POLICY_HPP__
+
+#include <cstddef>
+#include <string>
+
+/**
+ * Policies of the models for the bags of several messages
+ */
+enum class bag_policy{
+    in_order,
+    queue,
+    drop
+};
+
+/**
+ * What a model does with a message of a bag
+ */
+enum class bag_action{
+    take,  /**< The message is taken now */
+    hold,  /**< The message waits in the model */
+    drop   /**< The message is dropped */
+};
+
+/**
+ * @brief      What a model following a policy does with a message of a bag
+ *
+ * @param[in]  policy  bag policy of the model
+ * @param[in]  index   position of the message in the bag of its port, from 0
+ */
+inline bag_action bag_policy_action(bag_policy policy, size_t index) {
+    if (index == 0 || policy == bag_policy::in_order) {
+        return bag_action::take;
+    }
+    return (policy == bag_policy::queue) ? bag_action::hold : bag_action::drop;
+}
+
+/**
+ * @brief      Reads a policy from its name: in_order, queue or drop
+ * @return     false if the name isn't a policy, the policy is left unchanged then
+ */
+inline bool parse_bag_policy(const std::string &name, bag_policy &policy) {
+    if (name == "in_order") {
+        policy = bag_policy::in_order;
+    }else if (name == "queue") {
+        policy = bag_policy::queue;
+    }else if (name == "drop") {
+        policy = bag_policy::drop;
+    }else {
+        return false;
+    }
+    return true;
+}
+
+#endif /**< __BAG_POLICY_HPP__ */
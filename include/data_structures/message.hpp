@@ -14,20 +14,31 @@ using namespace std;
 
 /** Structure of message is defined by declaring the word message_t
  *  message_t is taking the float type of variable as a parameter
+ *  and carries the id of the flow it belongs to, 0 when there is
+ *  a single sender/receiver pair
  */
 struct message_t{
 
     message_t(){}
     message_t(float i_value)
     :value(i_value){}
+    message_t(float i_value, int i_flow)
+    :value(i_value), flow(i_flow){}
 
   	    float   value;
+        int     flow = 0;
 
     void clear() {
         message_t(); 
   	}
 };
 
+/** Value of a message damaged on a link, its content can't be read (see Subnet) */
+const float message_damaged = -1;
+
+/** A negative acknowledgement carries the alternating bit expected plus this offset */
+const int message_nak_offset = 2;
+
 istream& operator>> (istream& is, message_t& msg);
 
 ostream& operator<<(ostream& os, const message_t& msg);
@@ -0,0 +1,63 @@
+/** \brief header file which is containing a per model random number stream
+ *
+ * Defines a rand_stream structure. It reproduces the sequence of the C library
+ * rand() (additive feedback generator of glibc) but keeps its state inside the
+ * model, so models running in different threads or runners don't share one
+ * global sequence. Seeded with 1 it yields exactly what an unseeded rand() yields.
+ */
+
+#ifndef __RAND_STREAM_HPP__
+#define __RAND_STREAM_HPP__
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/** Structure of the random stream, it is copied with the model state */
+struct rand_stream{
+
+    rand_stream(){
+        seed(1);
+    }
+    rand_stream(unsigned int i_seed){
+        seed(i_seed);
+    }
+
+    uint32_t ring[31]; /**< Last 31 values of the additive feedback sequence */
+    int      front;    /**< Position of the oldest value in ring */
+
+    /**
+     * @brief      Restarts the stream, same as srand(i_seed)
+     * @param[in]  i_seed  seed of the stream, 0 is treated as 1
+     */
+    void seed(unsigned int i_seed) {
+        int32_t r[344];
+        r[0] = (i_seed == 0) ? 1 : i_seed;
+        for (int i = 1; i < 31; i++) {
+            int64_t word = (16807LL * r[i - 1]) % 2147483647;
+            r[i] = (word < 0) ? word + 2147483647 : word;
+        }
+        for (int i = 31; i < 34; i++) {
+            r[i] = r[i - 31];
+        }
+        for (int i = 34; i < 344; i++) {
+            r[i] = (uint32_t) r[i - 31] + (uint32_t) r[i - 3];
+        }
+        for (int i = 0; i < 31; i++) {
+            ring[i] = r[313 + i];
+        }
+        front = 0;
+    }
+
+    /**
+     * @brief      Next value of the stream, same as rand()
+     * @return     Integer between 0 and RAND_MAX
+     */
+    int next() {
+        uint32_t value = ring[front] + ring[(front + 28) % 31];
+        ring[front] = value;
+        front = (front + 1) % 31;
+        return value >> 1;
+    }
+};
+
+#endif // __RAND_STREAM_HPP__
@@ -0,0 +1,697 @@
+/** \brief Flat event kernel, an alternative to the cadmium dynamic runner
+ *
+ * The cadmium runner walks the coupled hierarchy on every step: each coordinator
+ * collects the outputs of its children, routes them through its couplings and
+ * builds new message bags at every level. flat_kernel runs the same atomic models
+ * (Sender, Receiver, Subnet, iestream_input, ...) through their PDEVS interface
+ * (output, internal/external/confluence transitions, time_advance) without the
+ * hierarchy:
+ *      - the next event of every atomic is kept in one binary heap
+ *      - the couplings are resolved once into routes from an output port of an
+ *        atomic to an input port of another one (a route is a pair of pointers to
+ *        the message vectors of the two bags)
+ *      - the bags of every atomic are allocated once and reused. Their vectors are
+ *        reserved when the atomic is added (bag_capacity messages per port), they
+ *        hold all the messages of a step and keep their capacity between steps.
+ *        Models with output_into and external/confluence_transition_from (Sender,
+ *        Receiver, Subnet, Mux, Demux) write and read these bags in place. Other
+ *        models (iestream_input) go through output() and by-value bags, which
+ *        allocate when they carry messages.
+ * Once every bag has reached its size, a step of such models allocates no memory.
+ *
+ * The state of a run can be saved between two steps and restored later (save,
+ * restore), e.g. to branch a run into several futures. The state of a model is
+ * a copy of its state member, or what its checkpoint() returns for models whose
+ * state can't be copied (ApplicationGen, which reads a file).
+ *
+ * The coupled models are only kept to write the trace, which is the one of the
+ * cadmium runner with logger_top (timestamps and messages): a coupled model logs
+ * its children when one of its atomics is imminent, an atomic logs its output
+ * when it is imminent and "[]" otherwise.
+ *
+ * Usage:
+ *      flat_kernel<NDTime> kernel(out_data);
+ *      int top = kernel.add_coupled("TOP");
+ *      kernel.add_atomic<ApplicationGen>("generator", top, input_file);
+ *      kernel.add_atomic<Receiver>("receiver1", top);
+ *      kernel.connect<iestream_input_defs<message_t>::out, receiver_defs::in>("generator", "receiver1");
+ *      kernel.run_until(NDTime("04:00:00:000"));
+ *      flat_kernel<NDTime>::snapshot saved = kernel.save();
+ *      kernel.run_until(NDTime("08:00:00:000"));
+ *      kernel.restore(saved);     // back at 04:00:00:000
+ * make_abp_flat in abp_topology.hpp builds the ABP simulator.
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#ifndef __FLAT_KERNEL_HPP__
+#define __FLAT_KERNEL_HPP__
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <memory>
+#include <limits>
+#include <utility>
+#include <type_traits>
+#include <typeindex>
+#include <stdexcept>
+#include <cstdlib>
+#include <cxxabi.h>
+
+#include <cadmium/modeling/message_bag.hpp>
+
+#include "data_structures/message.hpp"
+
+/**
+ * Detects the in place interface of a model: output_into(bags&) and
+ * external_transition_from(TIME, const bags&)
+ */
+template<typename MODEL, typename BAGS, typename = void>
+struct has_output_into : std::false_type {};
+template<typename MODEL, typename BAGS>
+struct has_output_into<MODEL, BAGS, std::void_t<decltype(
+    std::declval<const MODEL&>().output_into(std::declval<BAGS&>()))>> : std::true_type {};
+
+template<typename MODEL, typename TIME, typename BAGS, typename = void>
+struct has_transition_from : std::false_type {};
+template<typename MODEL, typename TIME, typename BAGS>
+struct has_transition_from<MODEL, TIME, BAGS, std::void_t<decltype(
+    std::declval<MODEL&>().external_transition_from(std::declval<TIME>(), std::declval<const BAGS&>())),
+    decltype(std::declval<MODEL&>().confluence_transition_from(std::declval<TIME>(), std::declval<const BAGS&>()))>>
+    : std::true_type {};
+
+/**
+ * Detects the checkpoint interface of a model: checkpoint() and restore(const checkpoint&)
+ */
+template<typename MODEL, typename = void>
+struct has_checkpoint : std::false_type {};
+template<typename MODEL>
+struct has_checkpoint<MODEL, std::void_t<decltype(
+    std::declval<MODEL&>().restore(std::declval<const MODEL&>().checkpoint()))>> : std::true_type {};
+
+/**
+ * @brief      Class running atomic models coupled by flat routes
+ */
+template<typename TIME>
+class flat_kernel{
+
+    /**
+     * Structure holding a route from an output port to an input port
+     */
+    struct route{
+        const std::vector<message_t> *from;
+        std::vector<message_t> *to;
+        int target;                 /**< Atomic receiving the messages */
+    };
+
+    /**
+     * Model interface seen by the kernel, implemented by atomic_model for every model class
+     */
+    struct atomic_abstract{
+        std::string id;
+        int node;                   /**< Node of the atomic in the hierarchy */
+        TIME last;
+        TIME next;
+        unsigned int version = 0;   /**< Heap entries of an older version are stale */
+        bool imminent = false;
+        bool has_input = false;
+        std::vector<route> routes;
+
+        virtual ~atomic_abstract() = default;
+        virtual TIME time_advance() const = 0;
+        virtual void output() = 0;
+        virtual void internal_transition() = 0;
+        virtual void external_transition(TIME) = 0;
+        virtual void confluence_transition(TIME) = 0;
+        virtual std::vector<message_t>* out_messages(std::type_index) = 0;
+        virtual std::vector<message_t>* in_messages(std::type_index) = 0;
+        virtual void log_output(std::ostream &) const = 0;
+        virtual std::shared_ptr<const void> save_state() const = 0;
+        virtual void restore_state(const std::shared_ptr<const void> &) = 0;
+    };
+
+    /**
+     * @brief      Class adapting a model class to the kernel
+     */
+    template<template<typename> class MODEL>
+    struct atomic_model : public atomic_abstract{
+        using out_bags = typename cadmium::make_message_bags<typename MODEL<TIME>::output_ports>::type;
+        using in_bags = typename cadmium::make_message_bags<typename MODEL<TIME>::input_ports>::type;
+        static constexpr size_t out_size = std::tuple_size<out_bags>::value;
+        static constexpr size_t in_size = std::tuple_size<in_bags>::value;
+
+        MODEL<TIME> model;
+        out_bags out;
+        in_bags in;
+        std::vector<std::string> out_names;
+
+        static constexpr bool in_place_output = has_output_into<MODEL<TIME>, out_bags>::value;
+        static constexpr bool in_place_input = has_transition_from<MODEL<TIME>, TIME, in_bags>::value;
+
+        template<typename... Args>
+        atomic_model(size_t capacity, Args&&... args) : model(std::forward<Args>(args)...) {
+            out_names = port_names<out_bags>(std::make_index_sequence<out_size>());
+            reserve(out, capacity, std::make_index_sequence<out_size>());
+            reserve(in, capacity, std::make_index_sequence<in_size>());
+        }
+
+        TIME time_advance() const override {
+            return model.time_advance();
+        }
+
+        void output() override {
+            if constexpr (in_place_output) {
+                model.output_into(out);
+            }else {
+                out = model.output();
+            }
+        }
+
+        void internal_transition() override {
+            model.internal_transition();
+        }
+
+        void external_transition(TIME e) override {
+            if constexpr (in_place_input) {
+                model.external_transition_from(e, in);
+            }else {
+                model.external_transition(e, in);
+            }
+            clear(in, std::make_index_sequence<in_size>());
+        }
+
+        void confluence_transition(TIME e) override {
+            if constexpr (in_place_input) {
+                model.confluence_transition_from(e, in);
+            }else {
+                model.confluence_transition(e, in);
+            }
+            clear(in, std::make_index_sequence<in_size>());
+        }
+
+        std::vector<message_t>* out_messages(std::type_index port) override {
+            return find_port(out, port, std::make_index_sequence<out_size>());
+        }
+
+        std::vector<message_t>* in_messages(std::type_index port) override {
+            return find_port(in, port, std::make_index_sequence<in_size>());
+        }
+
+        std::shared_ptr<const void> save_state() const override {
+            if constexpr (has_checkpoint<MODEL<TIME>>::value) {
+                return std::make_shared<decltype(model.checkpoint())>(model.checkpoint());
+            }else if constexpr (std::is_copy_assignable<typename MODEL<TIME>::state_type>::value) {
+                return std::make_shared<typename MODEL<TIME>::state_type>(model.state);
+            }else {
+                throw std::logic_error("the state of atomic " + this->id + " can't be saved");
+            }
+        }
+
+        void restore_state(const std::shared_ptr<const void> &saved) override {
+            if constexpr (has_checkpoint<MODEL<TIME>>::value) {
+                model.restore(*static_cast<const decltype(model.checkpoint())*>(saved.get()));
+            }else if constexpr (std::is_copy_assignable<typename MODEL<TIME>::state_type>::value) {
+                model.state = *static_cast<const typename MODEL<TIME>::state_type*>(saved.get());
+            }else {
+                throw std::logic_error("the state of atomic " + this->id + " can't be restored");
+            }
+        }
+
+        /** Writes the output bags as the cadmium logger does: [port: {v1, v2}, port: {}] */
+        void log_output(std::ostream &os) const override {
+            os << "[";
+            log_bags(os, std::make_index_sequence<out_size>());
+            os << "] generated by model " << this->id << '\n';
+        }
+
+        template<size_t... I>
+        void log_bags(std::ostream &os, std::index_sequence<I...>) const {
+            ((os << (I == 0 ? "" : ", ") << out_names[I] << ": {",
+              log_messages(os, std::get<I>(out).messages),
+              os << "}"), ...);
+        }
+
+        static void log_messages(std::ostream &os, const std::vector<message_t> &messages) {
+            for (size_t i = 0; i < messages.size(); i++) {
+                os << (i == 0 ? "" : ", ") << messages[i];
+            }
+        }
+
+        template<typename BAGS, size_t... I>
+        static std::vector<message_t>* find_port(BAGS &bags, std::type_index port, std::index_sequence<I...>) {
+            std::vector<message_t> *found = nullptr;
+            ((std::type_index(typeid(typename std::tuple_element<I, BAGS>::type::port)) == port ?
+                  (void) (found = &std::get<I>(bags).messages) : (void) 0), ...);
+            return found;
+        }
+
+        template<typename BAGS, size_t... I>
+        static void clear(BAGS &bags, std::index_sequence<I...>) {
+            (std::get<I>(bags).messages.clear(), ...);
+        }
+
+        template<typename BAGS, size_t... I>
+        static void reserve(BAGS &bags, size_t capacity, std::index_sequence<I...>) {
+            (std::get<I>(bags).messages.reserve(capacity), ...);
+        }
+
+        template<typename BAGS, size_t... I>
+        static std::vector<std::string> port_names(std::index_sequence<I...>) {
+            return {type_name(typeid(typename std::tuple_element<I, BAGS>::type::port))...};
+        }
+    };
+
+    /**
+     * Structure holding a model of the hierarchy, coupled or atomic
+     */
+    struct node{
+        std::string id;
+        int atomic;                 /**< Index of the atomic, -1 for a coupled model */
+        std::vector<int> children;
+        long long active_step = -1; /**< Last step in which an atomic below was imminent */
+    };
+
+    /**
+     * Structure holding an entry of the heap
+     */
+    struct event{
+        TIME time;
+        int atomic;
+        unsigned int version;
+    };
+
+    public:
+        /**
+         * Structure holding the state of a run between two steps, see save and restore.
+         * The states of the models are shared by the copies of a snapshot.
+         */
+        struct snapshot{
+            std::vector<std::shared_ptr<const void>> states;
+            std::vector<TIME> last;
+            std::vector<TIME> next;
+            std::vector<unsigned int> versions;
+            std::vector<event> heap;
+            bool initialized = false;
+            long long step_count = 0;
+            long long transition_count = 0;
+        };
+
+    private:
+    std::ostream *sink;
+    size_t bag_capacity;
+    std::vector<std::unique_ptr<atomic_abstract>> atomics;
+    std::vector<node> nodes;
+    std::vector<int> parents;
+    std::vector<int> roots;
+    std::map<std::string, int> atomic_ids;
+    std::vector<event> heap;
+    std::vector<int> imminents;
+    std::vector<int> receivers;
+    bool initialized = false;
+    long long step_count = 0;
+    long long transition_count = 0;
+
+    public:
+        /**
+         * @param[in]  o_sink          stream receiving the trace
+         * @param[in]  i_bag_capacity  messages reserved in every port of the bags
+         */
+        flat_kernel(std::ostream &o_sink, size_t i_bag_capacity = 4)
+            : sink(&o_sink), bag_capacity(i_bag_capacity) {}
+
+        /**
+         * @brief      Kernel writing no trace, e.g. to measure the models alone
+         */
+        flat_kernel(size_t i_bag_capacity = 4) : sink(nullptr), bag_capacity(i_bag_capacity) {}
+
+        /**
+         * @brief      Adds a coupled model, used to write the trace in the order of cadmium
+         *
+         * @param[in]  id      id of the coupled model
+         * @param[in]  parent  coupled model holding it, -1 for the TOP model
+         * @return     The coupled model, to be used as parent
+         */
+        int add_coupled(const std::string &id, int parent = -1) {
+            return add_node(id, -1, parent);
+        }
+
+        /**
+         * @brief      Adds an atomic model of class MODEL<TIME>
+         *
+         * @param[in]  id      id of the atomic, written in the trace
+         * @param[in]  parent  coupled model holding it
+         * @param[in]  args    arguments of the constructor of the model
+         * @return     The node of the atomic
+         */
+        template<template<typename> class MODEL, typename... Args>
+        int add_atomic(const std::string &id, int parent, Args&&... args) {
+            if (atomic_ids.count(id) != 0) {
+                throw std::invalid_argument("duplicated atomic id " + id);
+            }
+            std::unique_ptr<atomic_abstract> a(new atomic_model<MODEL>(bag_capacity, std::forward<Args>(args)...));
+            a->id = id;
+            a->node = add_node(id, atomics.size(), parent);
+            atomic_ids[id] = atomics.size();
+            atomics.push_back(std::move(a));
+            return atomics.back()->node;
+        }
+
+        /**
+         * @brief      Routes the messages of port FROM of an atomic to port TO of another one
+         *
+         * The couplings of the cadmium models, through any number of coupled models,
+         * become one connect between the two atomics. Messages reaching one port
+         * from several routes are delivered in the order of the connects.
+         */
+        template<typename FROM, typename TO>
+        void connect(const std::string &from_id, const std::string &to_id) {
+            atomic_abstract &from = atomic(from_id);
+            atomic_abstract &to = atomic(to_id);
+            route r;
+            r.from = from.out_messages(typeid(FROM));
+            r.to = to.in_messages(typeid(TO));
+            r.target = atomic_ids[to_id];
+            if (r.from == nullptr || r.to == nullptr) {
+                throw std::invalid_argument("no port to connect " + from_id + " to " + to_id);
+            }
+            from.routes.push_back(r);
+        }
+
+        /**
+         * @brief      Runs the models until the end time, events at end or later aren't run
+         * @return     Time of the next event
+         */
+        TIME run_until(const TIME &end) {
+            if (!initialized) {
+                initialize();
+            }
+            while (next() < end) {
+                step();
+            }
+            return next();
+        }
+
+        /**
+         * @brief      The model of an atomic of class MODEL<TIME>
+         * Lets the caller set its parameters or reset its state between two runs.
+         */
+        template<template<typename> class MODEL>
+        MODEL<TIME>& model(const std::string &id) {
+            atomic_model<MODEL> *a = dynamic_cast<atomic_model<MODEL>*>(&atomic(id));
+            if (a == nullptr) {
+                throw std::invalid_argument("atomic " + id + " isn't of the requested class");
+            }
+            return a->model;
+        }
+
+        /**
+         * @brief      Re-arms the kernel for another run of the same models
+         *
+         * The next run starts at time 0 and writes its trace to o_sink. The
+         * atomics, routes, bags and heap are kept with their capacity, so a built
+         * topology runs again without being rebuilt. The models keep their state:
+         * reset them first (see reset_abp_flat in abp_topology.hpp).
+         */
+        void reset(std::ostream &o_sink) {
+            reset();
+            sink = &o_sink;
+        }
+
+        /**
+         * @brief      Re-arms the kernel for another run writing no trace
+         */
+        void reset() {
+            sink = nullptr;
+            initialized = false;
+            step_count = 0;
+            transition_count = 0;
+            heap.clear();
+            imminents.clear();
+            receivers.clear();
+            for (node &n : nodes) {
+                n.active_step = -1;
+            }
+            for (std::unique_ptr<atomic_abstract> &a : atomics) {
+                a->imminent = false;
+                a->has_input = false;
+            }
+        }
+
+        /**
+         * @brief      Runs the next step, the imminent atomics at the time of the next event
+         * @return     Time of the step
+         */
+        TIME run_step() {
+            if (!initialized) {
+                initialize();
+            }
+            TIME t = next();
+            step();
+            return t;
+        }
+
+        /**
+         * @brief      Saves the state of the run: the states of the models and their schedule
+         * Only valid between two steps. The bags are empty then and the routes don't change.
+         */
+        snapshot save() const {
+            snapshot saved;
+            saved.states.reserve(atomics.size());
+            for (const std::unique_ptr<atomic_abstract> &a : atomics) {
+                saved.states.push_back(a->save_state());
+                saved.last.push_back(a->last);
+                saved.next.push_back(a->next);
+                saved.versions.push_back(a->version);
+            }
+            saved.heap = heap;
+            saved.initialized = initialized;
+            saved.step_count = step_count;
+            saved.transition_count = transition_count;
+            return saved;
+        }
+
+        /**
+         * @brief      Puts the run back in a saved state, the next step is the one that followed it
+         * The trace keeps going to the current sink.
+         */
+        void restore(const snapshot &saved) {
+            for (size_t i = 0; i < atomics.size(); i++) {
+                atomics[i]->restore_state(saved.states[i]);
+                atomics[i]->last = saved.last[i];
+                atomics[i]->next = saved.next[i];
+                atomics[i]->version = saved.versions[i];
+                atomics[i]->imminent = false;
+                atomics[i]->has_input = false;
+            }
+            heap = saved.heap;
+            initialized = saved.initialized;
+            step_count = saved.step_count;
+            transition_count = saved.transition_count;
+            for (node &n : nodes) {
+                n.active_step = -1;
+            }
+        }
+
+        /** Time of the next event, infinity if none is scheduled. The first call schedules the atomics */
+        TIME next() {
+            if (!initialized) {
+                initialize();
+            }
+            while (!heap.empty() && atomics[heap.front().atomic]->version != heap.front().version) {
+                pop_event();
+            }
+            return heap.empty() ? std::numeric_limits<TIME>::infinity() : heap.front().time;
+        }
+
+        /** Number of steps (timestamps of the trace) run */
+        long long steps() const {
+            return step_count;
+        }
+
+        /** Number of transitions of the atomics run */
+        long long transitions() const {
+            return transition_count;
+        }
+
+    private:
+        int add_node(const std::string &id, int atomic_index, int parent) {
+            nodes.push_back(node{id, atomic_index, {}, -1});
+            parents.push_back(parent);
+            int index = nodes.size() - 1;
+            if (parent >= 0) {
+                nodes[parent].children.push_back(index);
+            }else {
+                roots.push_back(index);
+            }
+            return index;
+        }
+
+        atomic_abstract& atomic(const std::string &id) {
+            auto it = atomic_ids.find(id);
+            if (it == atomic_ids.end()) {
+                throw std::invalid_argument("unknown atomic id " + id);
+            }
+            return *atomics[it->second];
+        }
+
+        /** Logs the initial time and schedules the first event of every atomic */
+        void initialize() {
+            initialized = true;
+            TIME t0 = TIME();
+            if (sink != nullptr) {
+                *sink << t0 << '\n';
+            }
+            for (size_t i = 0; i < atomics.size(); i++) {
+                atomics[i]->last = t0;
+                schedule(i, t0 + atomics[i]->time_advance());
+            }
+        }
+
+        void schedule(int index, const TIME &time) {
+            atomic_abstract &a = *atomics[index];
+            a.next = time;
+            a.version++;
+            if (time != std::numeric_limits<TIME>::infinity()) {
+                heap.push_back(event{time, index, a.version});
+                sift_up(heap.size() - 1);
+            }
+        }
+
+        static bool earlier(const event &a, const event &b) {
+            return a.time < b.time || (!(b.time < a.time) && a.atomic < b.atomic);
+        }
+
+        void sift_up(size_t i) {
+            while (i > 0) {
+                size_t parent = (i - 1) / 2;
+                if (!earlier(heap[i], heap[parent])) {
+                    break;
+                }
+                std::swap(heap[i], heap[parent]);
+                i = parent;
+            }
+        }
+
+        void pop_event() {
+            heap.front() = heap.back();
+            heap.pop_back();
+            size_t i = 0;
+            while (true) {
+                size_t child = 2 * i + 1;
+                if (child >= heap.size()) {
+                    break;
+                }
+                if (child + 1 < heap.size() && earlier(heap[child + 1], heap[child])) {
+                    child++;
+                }
+                if (!earlier(heap[child], heap[i])) {
+                    break;
+                }
+                std::swap(heap[i], heap[child]);
+                i = child;
+            }
+        }
+
+        /**
+         * @brief      Runs the imminent atomics: log, output, routing and transitions
+         */
+        void step() {
+            TIME t = next();
+            step_count++;
+            imminents.clear();
+            receivers.clear();
+            while (next() == t && !heap.empty()) {
+                int index = heap.front().atomic;
+                pop_event();
+                atomics[index]->imminent = true;
+                imminents.push_back(index);
+                for (int n = atomics[index]->node; n >= 0 && nodes[n].active_step != step_count; n = parents[n]) {
+                    nodes[n].active_step = step_count;
+                }
+            }
+
+            for (int index : imminents) {
+                atomics[index]->output();
+            }
+            if (sink != nullptr) {
+                *sink << t << '\n';
+                for (int n : roots) {
+                    if (nodes[n].active_step == step_count) {
+                        log_node(n);
+                    }
+                }
+            }
+
+            for (int index : imminents) {
+                for (const route &r : atomics[index]->routes) {
+                    if (r.from->empty()) {
+                        continue;
+                    }
+                    r.to->insert(r.to->end(), r.from->begin(), r.from->end());
+                    atomic_abstract &target = *atomics[r.target];
+                    if (!target.has_input) {
+                        target.has_input = true;
+                        if (!target.imminent) {
+                            receivers.push_back(r.target);
+                        }
+                    }
+                }
+            }
+
+            for (int index : imminents) {
+                atomic_abstract &a = *atomics[index];
+                if (a.has_input) {
+                    a.confluence_transition(t - a.last);
+                }else {
+                    a.internal_transition();
+                }
+                finish_transition(index, t);
+            }
+            for (int index : receivers) {
+                atomic_abstract &a = *atomics[index];
+                a.external_transition(t - a.last);
+                finish_transition(index, t);
+            }
+        }
+
+        void finish_transition(int index, const TIME &t) {
+            atomic_abstract &a = *atomics[index];
+            a.imminent = false;
+            a.has_input = false;
+            a.last = t;
+            transition_count++;
+            schedule(index, t + a.time_advance());
+        }
+
+        void log_node(int n) {
+            for (int child : nodes[n].children) {
+                const node &c = nodes[child];
+                if (c.atomic >= 0) {
+                    const atomic_abstract &a = *atomics[c.atomic];
+                    if (a.imminent) {
+                        a.log_output(*sink);
+                    }else {
+                        *sink << "[] generated by model " << a.id << '\n';
+                    }
+                }else if (c.active_step == step_count) {
+                    log_node(child);
+                }
+            }
+        }
+
+        static std::string type_name(const std::type_info &type) {
+            int status = 0;
+            char *name = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+            std::string result = (status == 0) ? name : type.name();
+            free(name);
+            return result;
+        }
+};
+
+#endif // __FLAT_KERNEL_HPP__
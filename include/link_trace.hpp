@@ -0,0 +1,243 @@
+/** \brief This header file contains the recorded link traces replayed by the Subnet.
+ *
+ * A link trace records the delay and the loss of the packets of a real link, in one
+ * of two csv formats told apart by their header:
+ *      per packet, the nth record is the fate of the nth packet sent on the link
+ *          Delay,Lost
+ *          2950,0
+ *          3120,1
+ *      time indexed, a record holds from its time until the time of the next one
+ *          Time,Delay,Lost
+ *          00:00:00:000,2950,0
+ *          00:05:00:000,4100,1
+ * Delays are in milliseconds, Lost is 1 for a lost packet. Times are never decreasing,
+ * the time of the last record is the length of the trace.
+ *
+ * The trace is memory mapped and read in place, records are parsed when a subnet gets
+ * to them, so a multi-GB trace is never loaded: only the pages around the cursors of
+ * the subnets are read, and release() gives back the ones they have passed. A trace is
+ * read only once opened, one trace can be shared by the subnets of every thread.
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+#ifndef __LINK_TRACE_HPP_
+#define __LINK_TRACE_HPP_
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "trace_scan.hpp"
+
+using namespace std;
+
+/** Bytes of a trace read between two releases of their pages */
+const size_t link_trace_release_bytes = 64 << 20;
+
+/**
+ * Structure holding a record of a link trace
+ */
+struct link_trace_record{
+    long long time_ms = 0;   /**< Start of the record, 0 in a per packet trace */
+    long long delay_ms = 0;
+    bool lost = false;
+};
+
+/**
+ * @brief      Class mapping a link trace file
+ */
+class link_trace{
+    public:
+        /**
+         * @brief      Maps a trace and reads its header
+         * @param[in]  path  the csv of the trace
+         */
+        link_trace(const string &path) {
+            int fd = open(path.c_str(), O_RDONLY);
+            struct stat stat_buff;
+            if (fd < 0 || fstat(fd, &stat_buff) != 0 || stat_buff.st_size == 0) {
+                message = "can't read " + path;
+                if (fd >= 0) {
+                    close(fd);
+                }
+                return;
+            }
+            length = stat_buff.st_size;
+            void *mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (mapped == MAP_FAILED) {
+                message = "can't map " + path;
+                length = 0;
+                return;
+            }
+            data = static_cast<const char *>(mapped);
+            madvise(mapped, length, MADV_SEQUENTIAL);
+
+            const char *header_end = static_cast<const char *>(memchr(data, '\n', length));
+            string header(data, header_end ? header_end - data : length);
+            if (!header.empty() && header.back() == '\r') {
+                header.pop_back();
+            }
+            if (header == "Time,Delay,Lost") {
+                timed = true;
+            }else if (header != "Delay,Lost") {
+                message = path + " has no Delay,Lost nor Time,Delay,Lost header";
+                return;
+            }
+            start = header_end ? header_end - data + 1 : length;
+
+            /** The last record gives the length of a time indexed trace */
+            size_t last = length;
+            while (last > start && (data[last - 1] == '\n' || data[last - 1] == '\r')) {
+                --last;
+            }
+            while (last > start && data[last - 1] != '\n') {
+                --last;
+            }
+            link_trace_record record;
+            size_t offset = last;
+            if (last < length && read(offset, record)) {
+                end_ms = record.time_ms;
+                valid = true;
+            }else {
+                message = path + " has no record";
+            }
+        }
+
+        ~link_trace() {
+            if (data != nullptr) {
+                munmap(const_cast<char *>(data), length);
+            }
+        }
+
+        link_trace(const link_trace &) = delete;
+        link_trace& operator=(const link_trace &) = delete;
+
+        /** Whether the trace is mapped and has records */
+        bool is_open() const {
+            return valid;
+        }
+
+        /** Why the trace isn't open */
+        const string& error() const {
+            return message;
+        }
+
+        /** Whether the records are time indexed rather than per packet */
+        bool time_indexed() const {
+            return timed;
+        }
+
+        /** Time of the last record of a time indexed trace */
+        long long last_time_ms() const {
+            return end_ms;
+        }
+
+        /** Offset of the first record */
+        size_t first() const {
+            return start;
+        }
+
+        /**
+         * @brief      Reads the record at an offset
+         * Lines which aren't records (empty lines) are skipped.
+         * @param[in,out] offset  offset of the record, moved to the next one
+         * @param[out]    record  the record
+         * @return     false at the end of the trace
+         */
+        bool read(size_t &offset, link_trace_record &record) const {
+            while (offset < length) {
+                const char *line = data + offset;
+                const char *line_end = static_cast<const char *>(memchr(line, '\n', length - offset));
+                size_t line_length = line_end ? line_end - line : length - offset;
+                offset += line_length + 1;
+                if (parse(line, line_length, record)) {
+                    return true;
+                }
+            }
+            offset = length;
+            return false;
+        }
+
+        /**
+         * @brief      Skips records
+         * Every non empty line is a record, the lines are counted with memchr without
+         * parsing them and the pages passed are released as the offset moves on.
+         * @return     Offset of the record after the skipped ones, the end if there aren't enough
+         */
+        size_t skip(size_t offset, long long records) const {
+            size_t released = offset;
+            while (records > 0 && offset < length) {
+                const char *line_end = static_cast<const char *>(memchr(data + offset, '\n', length - offset));
+                size_t next = line_end ? line_end - data + 1 : length;
+                if (data[offset] != '\n' && data[offset] != '\r') {
+                    --records;
+                }
+                offset = next;
+                if (offset >= released + link_trace_release_bytes) {
+                    release(released, offset);
+                    released = offset;
+                }
+            }
+            release(released, offset);
+            return offset;
+        }
+
+        /**
+         * @brief      Gives back the pages of a part of the trace already read
+         * They are read again from the page cache, or the file, if they are needed later.
+         */
+        void release(size_t from, size_t to) const {
+            size_t page = (size_t) sysconf(_SC_PAGESIZE);
+            size_t aligned_from = (from + page - 1) / page * page;
+            size_t aligned_to = to / page * page;
+            if (aligned_from < aligned_to && aligned_to <= length) {
+                madvise(const_cast<char *>(data) + aligned_from, aligned_to - aligned_from, MADV_DONTNEED);
+            }
+        }
+
+    private:
+        const char *data = nullptr;
+        size_t length = 0;
+        size_t start = 0;          /**< Offset of the first record */
+        bool timed = false;
+        bool valid = false;
+        long long end_ms = 0;
+        string message;
+
+        /** Parses "Delay,Lost" or "Time,Delay,Lost" */
+        bool parse(const char *line, size_t line_length, link_trace_record &record) const {
+            size_t pos = 0;
+            record.time_ms = 0;
+            if (timed) {
+                if (line_length < 13 || line[12] != ',') {
+                    return false;
+                }
+                record.time_ms = parse_fixed_time_ms(line);
+                if (record.time_ms < 0) {
+                    return false;
+                }
+                pos = 13;
+            }
+            long long delay = 0;
+            size_t digits = 0;
+            for (; pos < line_length && line[pos] >= '0' && line[pos] <= '9'; pos++, digits++) {
+                delay = delay * 10 + (line[pos] - '0');
+            }
+            if (digits == 0 || pos + 1 >= line_length || line[pos] != ',') {
+                return false;
+            }
+            record.delay_ms = delay;
+            record.lost = (line[pos + 1] == '1');
+            return true;
+        }
+};
+
+#endif /**< __LINK_TRACE_HPP_ */
@@ -0,0 +1,125 @@
+/** \brief Allocation and resident memory instrumentation per simulation phase
+ *
+ * Built with -DABP_MEM_INSTRUMENTATION (make MEM_INSTRUMENTATION=1),
+ * mem_instrumentation.cpp replaces the global operator new and delete to count
+ * the allocations, the allocated bytes and the peak of live heap bytes. Without
+ * it the counters stay at 0 and only the resident memory is measured, so the
+ * instrumentation costs nothing unless it is asked for.
+ *
+ * phase_metrics splits a run into phases (model, runner, simulation, ...) and
+ * records for each one its duration, allocations, bytes, peak live heap bytes and
+ * peak resident memory. The peak resident memory of a phase is read from VmHWM
+ * after resetting it at the start of the phase (/proc/self/clear_refs). Where
+ * that can't be reset the peak is the one of the process so far. The phases are
+ * appended to the run metrics file, one row each:
+ *      Program,Phase,Secs,Allocations,Bytes,PeakHeapBytes,PeakRSSkB,Events,AllocsPerEvent
+ *
+ * Usage:
+ *      phase_metrics metrics("ABP");
+ *      metrics.begin("model");
+ *      ...
+ *      metrics.begin("simulation");   // ends the previous phase
+ *      ...
+ *      metrics.end();
+ *      metrics.set_events("simulation", events);
+ *      metrics.write("./data/run_metrics.csv");
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+#ifndef __MEM_INSTRUMENTATION_HPP_
+#define __MEM_INSTRUMENTATION_HPP_
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+
+using namespace std;
+
+/**
+ * Structure holding the counters of the operator new hooks
+ */
+struct mem_counters{
+    long long allocations = 0;
+    long long frees = 0;
+    long long bytes = 0;          /**< Bytes allocated since the start of the process */
+    long long live_bytes = 0;     /**< Bytes allocated and not freed */
+    long long peak_live_bytes = 0;
+};
+
+/** true if the operator new hooks are compiled in */
+bool mem_instrumentation_enabled();
+
+/** Current value of the counters */
+mem_counters mem_snapshot();
+
+/** Restarts the peak of live heap bytes from the current live bytes */
+void reset_peak_live_bytes();
+
+/** Resident memory of the process in kB (VmRSS), -1 if unknown */
+long current_rss_kb();
+
+/** Peak resident memory in kB since the last reset_peak_rss (VmHWM), -1 if unknown */
+long peak_rss_kb();
+
+/**
+ * @brief      Restarts the peak resident memory from the current one
+ * @return     false if the kernel doesn't allow it, the peak is then the one of the process
+ */
+bool reset_peak_rss();
+
+/**
+ * Structure holding the measures of one phase
+ */
+struct phase_record{
+    string phase;
+    double secs = 0;
+    long long allocations = 0;
+    long long bytes = 0;
+    long long peak_heap_bytes = 0;
+    long peak_rss_kb = 0;
+    long long events = 0;         /**< Events run in the phase, 0 if not an event phase */
+};
+
+/**
+ * @brief      Class measuring the phases of a run
+ */
+class phase_metrics{
+    public:
+        /**
+         * @param[in]  i_program  Name of the program written in the Program column
+         */
+        phase_metrics(const string &);
+
+        /** Ends the current phase, if any, and starts a new one */
+        void begin(const string &);
+
+        /** Ends the current phase */
+        void end();
+
+        /** Sets the number of events of a finished phase */
+        void set_events(const string &, long long);
+
+        const vector<phase_record>& phases() const;
+
+        /**
+         * @brief      Appends the phases to a run metrics file, writing the header if the file is new
+         * @return     false if the file can't be written
+         */
+        bool write(const string &) const;
+
+        /** Prints the phases in a table */
+        void print(ostream &) const;
+
+    private:
+        string program;
+        vector<phase_record> records;
+        bool running = false;
+        chrono::high_resolution_clock::time_point start;
+        mem_counters start_counters;
+};
+
+#endif /**< __MEM_INSTRUMENTATION_HPP_ */
@@ -0,0 +1,329 @@
+/** \brief Mux and Demux Classes are implemented in this header file
+ *
+ * They let M sender/receiver pairs share one Subnet. Every message carries the
+ * id of its flow (message_t::flow), stamped by the Sender and echoed by the
+ * Receiver on its acknowledgement.
+ *
+ * The Mux is the queue in front of the shared link. It accepts any number of
+ * messages at a time, keeps them in arrival order and releases one every
+ * service time, so the Subnet behind it only ever transmits one packet. The
+ * service time should not be shorter than the transit delay of the Subnet.
+ *
+ * A Demux is placed for every flow behind the shared link. All of them receive
+ * every message of the link and each one only passes the messages of its flow,
+ * so replies are routed back to the right sender.
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#ifndef __MUX_CADMIUM_HPP__
+#define __MUX_CADMIUM_HPP__
+
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/message_bag.hpp>
+#include <limits>
+#include <assert.h>
+#include <iostream>
+#include <string>
+#include <deque>
+#include <vector>
+
+#include "../include/data_structures/message.hpp"
+
+using namespace cadmium;
+using namespace std;
+
+/**
+ * @brief      Port Definition of the Mux
+ */
+struct mux_defs{
+    struct out : public out_port<message_t> {};
+    struct in : public in_port<message_t> {};
+};
+
+/**
+ * @brief      Class for Mux.
+ * The Mux queues the messages of all flows and releases them one at a time.
+ */
+template<typename TIME>
+class Mux{
+    /** putting definitions in context */
+    using defs = mux_defs;
+    public:
+        TIME service_time; /**< Time a message occupies the link, overwritten when instantiating */
+
+        /**
+         * @brief      Constructor of Mux Class
+         * The queue is empty and the service time is the transit delay of the Subnet.
+         */
+        Mux() noexcept{
+            service_time        = TIME("00:00:03");
+            state.next_internal = std::numeric_limits<TIME>::infinity();
+            state.served        = 0;
+        }
+
+        /**
+         * @brief      Constructor of Mux Class with its service time
+         * @param[in]  i_service_time  time between two released messages
+         */
+        Mux(TIME i_service_time) noexcept : Mux(){
+            service_time = i_service_time;
+        }
+
+        /**
+         * Structure that holds the queue of the link
+         */
+        struct state_type{
+            deque<message_t> queue; /**< Waiting messages, the front one is in service */
+            TIME next_internal;
+            int served;             /**< Number of released messages */
+        };
+        state_type state;
+
+        /** Intitialized the input and output ports */
+        using input_ports=std::tuple<typename defs::in>;
+        using output_ports=std::tuple<typename defs::out>;
+
+        /**
+         * Internal transition, the message in service has been released
+         * and the next one, if any, starts its service.
+         */
+        void internal_transition() {
+            state.queue.pop_front();
+            state.served++;
+            if (state.queue.empty()) {
+                state.next_internal = std::numeric_limits<TIME>::infinity();
+            }else {
+                state.next_internal = service_time;
+            }
+        }
+
+        /**
+         * @brief      External Transition Function
+         * All messages of the bag are queued in order. An idle Mux starts serving
+         * the first of them, a busy one keeps the remaining service time.
+         * @param[in]  e     type time variable
+         * @param[in]  mbs   message bags
+         */
+        void external_transition(TIME e,
+                                 typename make_message_bags<input_ports>::type mbs) {
+            external_transition_from(e, mbs);
+        }
+
+        /**
+         * @brief      External transition reading bags owned by the caller
+         * @param[in]  e     type time variable
+         * @param[in]  mbs   message bags
+         */
+        void external_transition_from(TIME e,
+                                      const typename make_message_bags<input_ports>::type &mbs) {
+            if (state.queue.empty()) {
+                state.next_internal = service_time;
+            }else {
+                state.next_internal = state.next_internal - e;
+            }
+            for (const auto &x : get_messages<typename defs::in>(mbs)) {
+                state.queue.push_back(x);
+            }
+            if (state.queue.empty()) {
+                state.next_internal = std::numeric_limits<TIME>::infinity();
+            }
+        }
+
+        /**
+         * @brief      Confluence Transition
+         * It initially calls the internal transtion function followed
+         * by external transition
+         * @param[in]  e     type time variable
+         * @param[in]  mbs   message bags
+         */
+        void confluence_transition(TIME e,
+                                   typename make_message_bags<input_ports>::type mbs) {
+            confluence_transition_from(e, mbs);
+        }
+
+        /**
+         * @brief      Confluence transition reading bags owned by the caller
+         * @param[in]  e     type time variable
+         * @param[in]  mbs   message bags
+         */
+        void confluence_transition_from(TIME e,
+                                        const typename make_message_bags<input_ports>::type &mbs) {
+            internal_transition();
+            external_transition_from(TIME(), mbs);
+        }
+
+        /**
+         * @brief      Messge bag fucntion
+         * Releases the message in service.
+         * @return     Message bags
+         */
+        typename make_message_bags<output_ports>::type output() const {
+            typename make_message_bags<output_ports>::type bags;
+            output_into(bags);
+            return bags;
+        }
+
+        /**
+         * @brief      Output function writing into bags reused by the caller
+         * @param[out] bags  Message bags, cleared first
+         */
+        void output_into(typename make_message_bags<output_ports>::type &bags) const {
+            get_messages<typename defs::out>(bags).clear();
+            get_messages<typename defs::out>(bags).push_back(state.queue.front());
+        }
+
+        /**
+         * @brief      Time Advance Function
+         * @return     remaining service time of the front message, infinity if empty
+         */
+        TIME time_advance() const {
+            return state.next_internal;
+        }
+
+        friend std::ostringstream& operator<<(std::ostringstream& os,
+                                              const typename Mux<TIME>::state_type& i) {
+            os << "queued: " << i.queue.size() << " & served: " << i.served;
+            return os;
+        }
+};
+
+/**
+ * @brief      Port Definition of the Demux
+ */
+struct demux_defs{
+    struct out : public out_port<message_t> {};
+    struct in : public in_port<message_t> {};
+};
+
+/**
+ * @brief      Class for Demux.
+ * The Demux passes the messages of its flow without delay and drops the others.
+ */
+template<typename TIME>
+class Demux{
+    /** putting definitions in context */
+    using defs = demux_defs;
+    public:
+        int flow; /**< Flow passed by this Demux */
+
+        /**
+         * @brief      Constructor of Demux Class, passes flow 0
+         */
+        Demux() noexcept{
+            flow = 0;
+        }
+
+        /**
+         * @brief      Constructor of Demux Class
+         * @param[in]  i_flow  flow passed by this Demux
+         */
+        Demux(int i_flow) noexcept{
+            flow = i_flow;
+        }
+
+        /**
+         * Structure that holds the messages to pass on
+         */
+        struct state_type{
+            vector<message_t> outbox;
+        };
+        state_type state;
+
+        /** Intitialized the input and output ports */
+        using input_ports=std::tuple<typename defs::in>;
+        using output_ports=std::tuple<typename defs::out>;
+
+        /**
+         * Internal transition, the messages have been passed on
+         */
+        void internal_transition() {
+            state.outbox.clear();
+        }
+
+        /**
+         * @brief      External Transition Function
+         * Keeps the messages of its flow.
+         * @param[in]  e     type time variable
+         * @param[in]  mbs   message bags
+         */
+        void external_transition(TIME e,
+                                 typename make_message_bags<input_ports>::type mbs) {
+            external_transition_from(e, mbs);
+        }
+
+        /**
+         * @brief      External transition reading bags owned by the caller
+         * @param[in]  e     type time variable
+         * @param[in]  mbs   message bags
+         */
+        void external_transition_from(TIME e,
+                                      const typename make_message_bags<input_ports>::type &mbs) {
+            for (const auto &x : get_messages<typename defs::in>(mbs)) {
+                if (x.flow == flow) {
+                    state.outbox.push_back(x);
+                }
+            }
+        }
+
+        /**
+         * @brief      Confluence Transition
+         * @param[in]  e     type time variable
+         * @param[in]  mbs   message bags
+         */
+        void confluence_transition(TIME e,
+                                   typename make_message_bags<input_ports>::type mbs) {
+            confluence_transition_from(e, mbs);
+        }
+
+        /**
+         * @brief      Confluence transition reading bags owned by the caller
+         * @param[in]  e     type time variable
+         * @param[in]  mbs   message bags
+         */
+        void confluence_transition_from(TIME e,
+                                        const typename make_message_bags<input_ports>::type &mbs) {
+            internal_transition();
+            external_transition_from(TIME(), mbs);
+        }
+
+        /**
+         * @brief      Messge bag fucntion
+         * @return     Message bags with the messages of the flow
+         */
+        typename make_message_bags<output_ports>::type output() const {
+            typename make_message_bags<output_ports>::type bags;
+            output_into(bags);
+            return bags;
+        }
+
+        /**
+         * @brief      Output function writing into bags reused by the caller
+         * @param[out] bags  Message bags, replaced by the messages of the flow
+         */
+        void output_into(typename make_message_bags<output_ports>::type &bags) const {
+            get_messages<typename defs::out>(bags).assign(state.outbox.begin(), state.outbox.end());
+        }
+
+        /**
+         * @brief      Time Advance Function
+         * @return     0 if there are messages to pass on, otherwise infinity
+         */
+        TIME time_advance() const {
+            if (state.outbox.empty()) {
+                return std::numeric_limits<TIME>::infinity();
+            }
+            return TIME();
+        }
+
+        friend std::ostringstream& operator<<(std::ostringstream& os,
+                                              const typename Demux<TIME>::state_type& i) {
+            os << "outbox: " << i.outbox.size();
+            return os;
+        }
+};
+
+#endif /** __MUX_CADMIUM_HPP__ */
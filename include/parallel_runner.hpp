@@ -0,0 +1,190 @@
+/** \brief Parallel runner for independent ABP pairs
+ *
+ * parallel_runner splits the pairs 1..M of make_abp_pairs_top into contiguous
+ * partitions and runs every partition with its own cadmium runner on its own
+ * thread. The pairs never exchange messages, so the partitions need no
+ * synchronization: every one of them runs to the end time on its own, there is
+ * no lookahead or window barrier between them. A topology whose partitions
+ * exchanged messages would need a conservative protocol, this one doesn't.
+ *
+ * Every partition logs its run into an in-memory sink (thread_sink.hpp). Once all
+ * of them are done the sinks are merged into the output stream by timestamp: the
+ * steps sharing a time are written under one timestamp, in the order of the
+ * partitions, which is the order of the pairs in the sequential TOP. The merged
+ * trace is identical to the trace of the sequential runner on the same pairs. The
+ * traces of the partitions are held in memory until the merge.
+ *
+ * Usage:
+ *      parallel_runner<NDTime> r(input, pairs, threads);
+ *      r.run_until(NDTime("04:00:00:000"), out_data);
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#ifndef __PARALLEL_RUNNER_HPP__
+#define __PARALLEL_RUNNER_HPP__
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <limits>
+#include <algorithm>
+#include <thread>
+
+#include <cadmium/engine/pdevs_dynamic_runner.hpp>
+
+#include "thread_sink.hpp"
+#include "trace_reader.hpp"
+#include "abp_topology.hpp"
+
+/**
+ * @brief      Class running the pairs of make_abp_pairs_top on several threads
+ */
+template<typename TIME>
+class parallel_runner{
+    using runner_type = cadmium::dynamic::engine::runner<TIME, thread_logger_top<TIME>>;
+
+    /**
+     * Structure holding a partition and its trace
+     */
+    struct partition{
+        int first;                  /**< First pair of the partition */
+        int last;                   /**< Last pair of the partition */
+        std::ostringstream trace;
+    };
+
+    /**
+     * Structure holding one step of a partition trace, a timestamp and its messages
+     */
+    struct step{
+        std::string time;
+        long long time_ms;
+        std::vector<std::string> lines;
+    };
+
+    std::string input;
+    std::vector<std::unique_ptr<partition>> partitions;
+
+    public:
+        /**
+         * @brief      Splits the pairs into partitions
+         *
+         * @param[in]  i_input      control input file played by every pair
+         * @param[in]  pairs        number of sender/receiver pairs (M)
+         * @param[in]  threads      number of partitions, at most one per pair
+         */
+        parallel_runner(const std::string &i_input, int pairs, int threads) : input(i_input) {
+            int count = std::max(1, std::min(threads, pairs));
+            int first = 1;
+            for (int p = 0; p < count; p++) {
+                std::unique_ptr<partition> part(new partition());
+                part->first = first;
+                part->last = first + pairs / count + (p < pairs % count ? 1 : 0) - 1;
+                first = part->last + 1;
+                partitions.push_back(std::move(part));
+            }
+        }
+
+        /** Number of partitions run side by side */
+        size_t size() const {
+            return partitions.size();
+        }
+
+        /**
+         * @brief      Runs every partition until the end time on its thread and writes the merged trace
+         *
+         * @param[in]  end         end time, events at end or later aren't run
+         * @param[out] o_d_stream  stream receiving the merged trace
+         */
+        void run_until(const TIME &end, std::ostream &o_d_stream) {
+            std::vector<std::thread> workers;
+            for (auto &part : partitions) {
+                workers.emplace_back(&parallel_runner::work, this, part.get(), end);
+            }
+            for (auto &worker : workers) {
+                worker.join();
+            }
+            merge(o_d_stream);
+            o_d_stream.flush();
+        }
+
+    private:
+        /**
+         * @brief      Thread of a partition, builds its pairs and runs them until the end time
+         * The runner is created by the thread, so the initial timestamp is logged into its sink.
+         */
+        void work(partition *part, TIME end) {
+            thread_sink_guard sink(part->trace);
+            std::shared_ptr<cadmium::dynamic::modeling::coupled<TIME>> TOP =
+                make_abp_pairs_top<TIME>(input.c_str(), part->first, part->last);
+            runner_type r(TOP, {0});
+            r.run_until(end);
+        }
+
+        /**
+         * @brief      Splits the trace of a partition into its steps
+         */
+        static std::vector<step> read_steps(const std::string &trace) {
+            std::vector<step> steps;
+            std::istringstream i_d_stream(trace);
+            std::string line;
+            while (getline(i_d_stream, line)) {
+                if (line.empty()) {
+                    continue;
+                }
+                if (line[0] != '[') {
+                    steps.push_back(step{line, parse_time_ms(line), {}});
+                }else if (!steps.empty()) {
+                    steps.back().lines.push_back(line);
+                }
+            }
+            return steps;
+        }
+
+        /**
+         * @brief      Writes the steps of every partition
+         *
+         * The k-th step at a time of every partition belongs to the k-th step of
+         * the sequential run at that time, so they are written together.
+         */
+        void merge(std::ostream &o_d_stream) {
+            std::vector<std::vector<step>> steps;
+            for (auto &part : partitions) {
+                steps.push_back(read_steps(part->trace.str()));
+                part->trace.str("");
+            }
+            std::vector<size_t> position(steps.size(), 0);
+            while (true) {
+                long long time_ms = -1;
+                for (size_t p = 0; p < steps.size(); p++) {
+                    if (position[p] < steps[p].size() &&
+                        (time_ms < 0 || steps[p][position[p]].time_ms < time_ms)) {
+                        time_ms = steps[p][position[p]].time_ms;
+                    }
+                }
+                if (time_ms < 0) {
+                    return;
+                }
+                bool time_written = false;
+                for (size_t p = 0; p < steps.size(); p++) {
+                    if (position[p] < steps[p].size() && steps[p][position[p]].time_ms == time_ms) {
+                        const step &s = steps[p][position[p]++];
+                        if (!time_written) {
+                            o_d_stream << s.time << '\n';
+                            time_written = true;
+                        }
+                        for (const std::string &line : s.lines) {
+                            o_d_stream << line << '\n';
+                        }
+                    }
+                }
+            }
+        }
+};
+
+#endif // __PARALLEL_RUNNER_HPP__
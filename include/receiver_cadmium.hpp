@@ -8,6 +8,29 @@
  * The status changes to the active state, when it receives the packet, and 
  * reverts the status to the passive state after sending an acknowledgment.
  * 
+ * By default every packet is acknowledged, duplicates included, so the reverse
+ * link carries as many messages as the forward one. With ACK_DELAY or ACK_EVERY
+ * set, the receiver holds its acknowledgement: the packets arriving meanwhile are
+ * coalesced into one cumulative acknowledgement of the last of them, sent
+ * PREPARATION_TIME after the ACK_EVERY-th held packet or at the latest
+ * ACK_DELAY + PREPARATION_TIME after the first one. ACK_EVERY > 1 needs an
+ * ACK_DELAY: without one nothing bounds the hold, so abp_check_parameters
+ * (abp_parameters.hpp) rejects it.
+ * 
+ * With NAK, a damaged packet (see Subnet::DAMAGE_ON_LOSS) is answered after
+ * PREPARATION_TIME with a negative acknowledgement of the alternating bit the
+ * receiver expects, so the sender can retransmit without waiting for its timeout.
+ * A damaged packet arriving while an acknowledgement is prepared or held is ignored:
+ * that acknowledgement answers the sender first.
+ * A duplicate, a packet with the unexpected alternating bit, is acknowledged as
+ * before: the sender then learns that its previous acknowledgement was lost.
+ * 
+ * A bag of several packets is taken following BAG_HANDLING (see bag_policy.hpp).
+ * In order, the packets are received one after the other and the acknowledgement
+ * answers the last of them. Queued packets are received one after each sent
+ * acknowledgement, or at once while the receiver is passive (a damaged packet
+ * it ignores, an acknowledgement held with no ACK_DELAY). Dropped ones are counted.
+ * 
  */
 /**
 * Cristina Ruiz Martin
@@ -33,8 +56,10 @@
 #include <algorithm>
 #include <limits>
 #include <random>
+#include <deque>
 
 #include "../include/data_structures/message.hpp"
+#include "../include/data_structures/bag_policy.hpp"
 
 using namespace cadmium;
 using namespace std;
@@ -59,6 +84,10 @@ class Receiver{
         
         TIME PREPARATION_TIME; /**<Time delay constant holder from acknowledgement to output. */
                                /**< Time constant delay */
+        TIME ACK_DELAY;        /**< Longest time an acknowledgement is held, 0 for none */
+        int ACK_EVERY;         /**< Held packets which release the acknowledgement, 1 for none */
+        bool NAK;              /**< Damaged packets are answered with a negative acknowledgement */
+        bag_policy BAG_HANDLING; /**< Bags of several packets */
         /**
          * @brief      Constructs the object.
          * It it initializes the delay constant, sets the state acknowledgement
@@ -66,8 +95,35 @@ class Receiver{
          */
         Receiver() noexcept{
             PREPARATION_TIME  = TIME("00:00:10");
+            ACK_DELAY         = TIME("00:00:00");
+            ACK_EVERY         = 1;
+            NAK               = false;
+            BAG_HANDLING      = bag_policy::in_order;
+            reset();
+        }
+
+        /**
+         * @brief      Puts the receiver back in its initial state
+         * PREPARATION_TIME, ACK_DELAY, ACK_EVERY, NAK and BAG_HANDLING are kept, so a receiver
+         * can be reused by another run.
+         */
+        void reset() noexcept{
             state.ack_num      = 0;
             state.sending     = false;
+            state.flow        = 0;
+            state.held        = 0;
+            state.next_internal = std::numeric_limits<TIME>::infinity();
+            state.expected    = 1;
+            state.nak         = false;
+            state.pending.clear();
+            state.dropped     = 0;
+        }
+
+        /**
+         * @brief      Whether the acknowledgements are held and coalesced
+         */
+        bool delays_acks() const {
+            return ACK_DELAY != TIME() || ACK_EVERY > 1;
         }
         
         /**
@@ -78,6 +134,13 @@ class Receiver{
                             /**< Acknowledgement number */
             bool sending;   /**< State of the receiver, passive(false) or active(true) */
                             /**< Sending State */
+            int flow;       /**< Flow of the last packet, echoed on the acknowledgement */
+            int held;       /**< Packets covered by the held acknowledgement */
+            TIME next_internal; /**< Time left before the acknowledgement is sent */
+            int expected;   /**< Alternating bit of the next new packet, the first packet has 1 */
+            bool nak;       /**< The message being prepared is a negative acknowledgement */
+            std::deque<message_t> pending; /**< Packets of bags not received yet (bag_policy::queue) */
+            long dropped;   /**< Packets of bags dropped (bag_policy::drop) */
         }; 
         state_type state;
 
@@ -87,31 +150,111 @@ class Receiver{
 
         /**
          * Internal Transition function that resets the state sending state.
+         * A queued packet of an earlier bag is then received.
          */
         void internal_transition() {
             state.sending = false; 
+            state.nak = false;
+            state.held = 0;
+            state.next_internal = std::numeric_limits<TIME>::infinity();
+            take_pending(true);
+        }
+
+        /**
+         * @brief      Receives the queued packets of earlier bags (bag_policy::queue)
+         * One is received at the end of an internal transition, then more as long as the
+         * receiver stays passive, since no transition would receive them.
+         * @param[in]  after_internal  whether an internal transition just ended
+         */
+        void take_pending(bool after_internal) {
+            while (!state.pending.empty()
+                   && (after_internal || time_advance() == std::numeric_limits<TIME>::infinity())) {
+                after_internal = false;
+                message_t next = state.pending.front();
+                state.pending.pop_front();
+                receive(next);
+            }
         }
 
         /**
          * @brief      Function handles exteral transition.
-         * It fetches the message and checks if the number of messages 
-         * is more than 1, then asserts by sending the stated message and 
-         * changes the state to false. It then sets the acknowledge to the 
+         * It fetches the messages and takes them following BAG_HANDLING.
+         * It then sets the acknowledge to the 
          * message value and sets the sending state to true.
          * @param[in]  e     type time variable
          * @param[in]  mbs   message bags
          */
         void external_transition(TIME e, 
                                  typename make_message_bags<input_ports>::type mbs){ 
+            external_transition_from(e, mbs);
+        }
+
+        /**
+         * @brief      External transition reading bags owned by the caller
+         * Same as external_transition without copying the bags (see flat_kernel.hpp).
+         * @param[in]  e     type time variable
+         * @param[in]  mbs   message bags
+         */
+        void external_transition_from(TIME e,
+                                      const typename make_message_bags<input_ports>::type &mbs){
+            /** The time elapsed runs out once, whatever the packets of the bag, damaged ones included */
+            if (state.next_internal != std::numeric_limits<TIME>::infinity()) {
+                state.next_internal = state.next_internal - e;
+            }
 
-            if(get_messages<typename defs::in>(mbs).size()>1){ 
-                assert(false && "one message per time uniti");
+            const auto &packets = get_messages<typename defs::in>(mbs);
+            for(size_t i = 0; i < packets.size(); i++){
+                switch (bag_policy_action(BAG_HANDLING, i)) {
+                    case bag_action::take: receive(packets[i]); break;
+                    case bag_action::hold: state.pending.push_back(packets[i]); break;
+                    case bag_action::drop: state.dropped++; break;
+                }
+            }
+            take_pending(false);
+        }
+
+        /**
+         * @brief      Receives a packet
+         * @param[in]  x     the packet
+         */
+        void receive(const message_t &x) {
+            if (x.value == message_damaged) {
+                /** An acknowledgement being prepared or held already answers the sender, the damaged packet is ignored */
+                if (NAK && !state.sending) {
+                    state.nak = true;
+                    state.flow = x.flow;
+                    state.sending = true;
+                    state.next_internal = PREPARATION_TIME;
+                }
+                return;
+            }
+            state.ack_num = static_cast < int > (x.value);
+            state.flow = x.flow;
+            state.sending = true;
+            state.nak = false;
+            state.expected = 1 - state.ack_num % 2;
+            if (delays_acks()) {
+                hold_ack();
+            } else {
+                /** Every packet restarts the preparation of its acknowledgement */
+                state.next_internal = PREPARATION_TIME;
+            }
+        }
+
+        /**
+         * @brief      Holds the acknowledgement of the packet just received
+         * The first held packet starts the ACK_DELAY, the next ones keep the time
+         * left and the ACK_EVERY-th one sends the acknowledgement after PREPARATION_TIME.
+         */
+        void hold_ack() {
+            const TIME infinity = std::numeric_limits<TIME>::infinity();
+            state.held++;
+            if (state.held == 1) {
+                state.next_internal = (ACK_DELAY != TIME()) ? PREPARATION_TIME + ACK_DELAY : infinity;
+            }
+            if (ACK_EVERY > 1 && state.held >= ACK_EVERY && PREPARATION_TIME < state.next_internal) {
+                state.next_internal = PREPARATION_TIME;
             }
-            for(const auto &x : get_messages<typename defs::in>(mbs)){
-              state.ack_num = static_cast < int > (x.value);
-              state.sending = true;
-            }  
-                       
         }
 
         /**
@@ -123,37 +266,63 @@ class Receiver{
          */
         void confluence_transition(TIME e, 
                                    typename make_message_bags<input_ports>::type mbs) {
+            confluence_transition_from(e, mbs);
+        }
+
+        /**
+         * @brief      Confluence transition reading bags owned by the caller
+         * @param[in]  e     type time variable
+         * @param[in]  mbs   message bags
+         */
+        void confluence_transition_from(TIME e,
+                                        const typename make_message_bags<input_ports>::type &mbs) {
 
             internal_transition();
-            external_transition(TIME(), std::move(mbs));
+            external_transition_from(TIME(), mbs);
         }
 
         /**
          * @brief      Messge bag fucntion
          * It is responsible for sending acknowledge number to the ouput
          * port. Which is the remainder, when the acknowledge number is divided
-         * by 10.
+         * by 10. The acknowledgement belongs to the flow of the packet.
          * @return     Message bags
          */
         typename make_message_bags<output_ports>::type output() const {
             typename make_message_bags<output_ports>::type bags;
+            output_into(bags);
+            return bags;
+        }
+
+        /**
+         * @brief      Output function writing into bags reused by the caller
+         * The bags are cleared first and keep their capacity, so no memory is
+         * allocated once they have held a message.
+         * @param[out] bags  Message bags
+         */
+        void output_into(typename make_message_bags<output_ports>::type &bags) const {
+            get_messages<typename defs::out>(bags).clear();
             message_t out;              
-            out.value = state.ack_num % 10;
+            out.value = state.nak ? state.expected + message_nak_offset : state.ack_num % 10;
+            out.flow = state.flow;
             get_messages<typename defs::out>(bags).push_back(out);     
-            return bags;
         }
 
         /**
          * @brief      Time Advance Function
          * Function sets the next internal transition time.
          * If the current state of sending is true, then the internatl
-         * time is set to PREPARATION_TIME. Otherwise, it is set to infinity.
+         * time is set to what is left of PREPARATION_TIME. Otherwise, it is set to infinity.
+         * A held acknowledgement is sent when its time left runs out.
          * @return     Next internal time
          */
         TIME time_advance() const {  
+            if (delays_acks()) {
+                return state.next_internal;
+            }
             TIME next_internal;
             if (state.sending) {
-                next_internal = PREPARATION_TIME;
+                next_internal = state.next_internal;
             } else {
                 next_internal = std::numeric_limits<TIME>::infinity();
             }    
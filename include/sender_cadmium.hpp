@@ -20,8 +20,10 @@
 #include <algorithm>
 #include <limits>
 #include <random>
+#include <deque>
 
 #include "../include/data_structures/message.hpp"
+#include "../include/data_structures/bag_policy.hpp"
 
 using namespace cadmium;
 using namespace std;
@@ -42,13 +44,42 @@ class Sender{
         //Parameters to be overwriten when instantiating the atomic model
         TIME   PREPARATION_TIME;
         TIME   timeout;
+        int    flow;     // flow id stamped on the sent messages, 0 for a single pair
+        bool   nak_recovery; // a negative or damaged acknowledgement retransmits without waiting for the timeout
+        bool   overlap_preparation; // the next packet is prepared while the current one waits for its ack
+        bool   queue_requests; // control requests arriving during a transfer are queued instead of dropped
+        bag_policy bag_handling; // bags of several messages on a port, see bag_policy.hpp
         // default constructor
         Sender() noexcept{
             PREPARATION_TIME  = TIME("00:00:10");
             timeout           = TIME("00:00:20");
-            state.alt_bit     = 0;
+            flow              = 0;
+            nak_recovery      = false;
+            overlap_preparation = false;
+            queue_requests    = false;
+            bag_handling      = bag_policy::in_order;
+            reset();
+        }
+        // constructor for senders sharing a link, see mux_cadmium.hpp
+        Sender(int i_flow) noexcept : Sender(){
+            flow = i_flow;
+        }
+
+        // puts the sender back in its initial state, the parameters are kept
+        void reset() noexcept{
+            state.ack              = false;
+            state.packet_num       = 0;
+            state.total_packet_num = 0;
+            state.alt_bit          = 0;
+            state.sending          = false;
+            state.transmissions    = 0;
+            state.answered         = 0;
             state.next_internal    = std::numeric_limits<TIME>::infinity();
             state.model_active     = false;
+            state.preparation_left = std::numeric_limits<TIME>::infinity();
+            state.requests.clear();
+            state.pending.clear();
+            state.dropped          = 0;
         }
         
         // state definition
@@ -58,8 +89,14 @@ class Sender{
             int total_packet_num;
             int alt_bit;
             bool sending;
+            int transmissions;   // transmissions of the current packet, its retransmissions are one less
+            int answered;        // negative or damaged acknowledgements received for the current packet
             bool model_active;
             TIME next_internal;
+            TIME preparation_left; // preparation of the next packet left, infinity when not started
+            std::deque<int> requests; // packets of the requests waiting for the current transfer, in arrival order
+            std::deque<std::pair<bool, message_t>> pending; // messages of bags not taken yet, true for controlIn
+            long dropped;        // messages of bags dropped
         }; 
         state_type state;
         // ports definition
@@ -69,23 +106,51 @@ class Sender{
                                       typename defs::ackReceivedOut,
                                       typename defs::dataOut>;
 
+        // the preparation of the next packet goes on while time elapses
+        void prepare_next(TIME e) {
+            if (state.preparation_left != std::numeric_limits<TIME>::infinity()){
+                state.preparation_left = (e < state.preparation_left) ? state.preparation_left - e : TIME();
+            }
+        }
+
         // internal transition
         void internal_transition() {
+            prepare_next(state.next_internal);
             if (state.ack){
-                if (state.packet_num < state.total_packet_num){
-                    state.packet_num ++;
-                    state.ack = false;
+                // the last packet of a transfer is acked, the next queued request starts over its packets
+                // but keeps alternating the bit: acks of earlier retransmissions may still be on the way
+                bool next_request = state.packet_num >= state.total_packet_num && !state.requests.empty();
+                if (state.packet_num < state.total_packet_num || next_request){
+                    if (next_request){
+                        state.total_packet_num = state.requests.front();
+                        state.requests.pop_front();
+                        state.packet_num = 1;
+                    } else {
+                        state.packet_num ++;
+                    }
                     state.alt_bit = (state.alt_bit + 1) % 2;
+                    state.ack = false;
                     state.sending = true;
+                    state.transmissions = 0;
+                    state.answered = 0;
                     state.model_active = true; 
-                    state.next_internal = PREPARATION_TIME;   
+                    // with overlap_preparation only what is left of the preparation remains
+                    state.next_internal = (state.preparation_left != std::numeric_limits<TIME>::infinity())
+                                          ? state.preparation_left : PREPARATION_TIME;
                 } else {
                     state.model_active = false;
                     state.next_internal = std::numeric_limits<TIME>::infinity();
                 }
+                state.preparation_left = std::numeric_limits<TIME>::infinity();
             } else{
                 if (state.sending){
+                    // the first transmission of a packet starts the preparation of the next one
+                    if (overlap_preparation && state.transmissions == 0
+                        && (state.packet_num < state.total_packet_num || !state.requests.empty())){
+                        state.preparation_left = PREPARATION_TIME;
+                    }
                     state.sending = false;
+                    state.transmissions ++;
                     state.model_active = true;
                     state.next_internal = timeout;
                 } else {
@@ -94,62 +159,132 @@ class Sender{
                     state.next_internal = PREPARATION_TIME;    
                 } 
             }   
+            // a queued message of an earlier bag is taken once the transition is done
+            take_pending(true);
+        }
+
+        // takes the queued messages of earlier bags (bag_policy::queue): one at the end of an internal
+        // transition, then more as long as the sender stays passive, since no transition would take them
+        void take_pending(bool after_internal) {
+            while (!state.pending.empty()
+                   && (after_internal || state.next_internal == std::numeric_limits<TIME>::infinity())){
+                after_internal = false;
+                std::pair<bool, message_t> next = state.pending.front();
+                state.pending.pop_front();
+                if (next.first){
+                    receive_control(next.second);
+                } else {
+                    receive_ack(next.second);
+                }
+            }
         }
 
         // external transition
         void external_transition(TIME e, 
                                  typename make_message_bags<input_ports>::type mbs) { 
+            external_transition_from(e, mbs);
+        }
+
+        // external transition reading bags owned by the caller (see flat_kernel.hpp)
+        void external_transition_from(TIME e,
+                                      const typename make_message_bags<input_ports>::type &mbs) {
           
-            if((get_messages<typename defs::controlIn>(mbs).size()+
-                get_messages<typename defs::ackIn>(mbs).size())>1){
-                assert(false && "one message per time uniti");
+            prepare_next(e);
+            // the time elapsed runs out once, whatever the messages of the bag, they restart it if needed
+            if(state.next_internal != std::numeric_limits<TIME>::infinity()){
+                state.next_internal = state.next_internal - e;
             }
 
-            for(const auto &x : get_messages<typename defs::controlIn>(mbs)){
-                if(state.model_active == false){
-                    state.total_packet_num = static_cast < int > (x.value);
-                    if (state.total_packet_num > 0){
-                        state.packet_num = 1;
-                        state.ack = false;
-                        state.sending = true;
-                        state.alt_bit = state.packet_num % 2;  //set initial alt_bit
-                        state.model_active = true;
-                        state.next_internal = PREPARATION_TIME;
-                    }else{
-                        if(state.next_internal != std::numeric_limits<TIME>::infinity()){
-                            state.next_internal = state.next_internal - e;
-                        }
-                    }
+            const auto &controls = get_messages<typename defs::controlIn>(mbs);
+            for(size_t i = 0; i < controls.size(); i++){
+                switch (bag_policy_action(bag_handling, i)) {
+                    case bag_action::take: receive_control(controls[i]); break;
+                    case bag_action::hold: state.pending.push_back(std::make_pair(true, controls[i])); break;
+                    case bag_action::drop: state.dropped++; break;
                 }
             }
 
-            for(const auto &x : get_messages<typename defs::ackIn>(mbs)){
-                if(state.model_active == true) { 
-                    if (state.alt_bit == static_cast < int > (x.value)) {
-                        state.ack = true;
-                        state.sending = false;
-                        state.next_internal = TIME("00:00:00");
-                    }else{
-                        if(state.next_internal != std::numeric_limits<TIME>::infinity()){
-                            state.next_internal = state.next_internal - e;
-                        }
-                    }
+            const auto &acks = get_messages<typename defs::ackIn>(mbs);
+            for(size_t i = 0; i < acks.size(); i++){
+                switch (bag_policy_action(bag_handling, i)) {
+                    case bag_action::take: receive_ack(acks[i]); break;
+                    case bag_action::hold: state.pending.push_back(std::make_pair(false, acks[i])); break;
+                    case bag_action::drop: state.dropped++; break;
                 }
-            }  
-                       
+            }
+            take_pending(false);
+        }
+
+        // control request
+        void receive_control(const message_t &x) {
+            if(state.model_active == false){
+                state.total_packet_num = static_cast < int > (x.value);
+                if (state.total_packet_num > 0){
+                    state.packet_num = 1;
+                    state.ack = false;
+                    state.sending = true;
+                    state.transmissions = 0;
+                    state.answered = 0;
+                    state.preparation_left = std::numeric_limits<TIME>::infinity();
+                    state.alt_bit = state.packet_num % 2;  //set initial alt_bit
+                    state.model_active = true;
+                    state.next_internal = PREPARATION_TIME;
+                }
+            }else if(queue_requests && static_cast < int > (x.value) > 0){
+                // served once the current transfer and the requests before it are done
+                state.requests.push_back(static_cast < int > (x.value));
+            }
+        }
+
+        // acknowledgement
+        void receive_ack(const message_t &x) {
+            if(state.model_active == true) { 
+                bool negative = nak_recovery && !state.ack && state.transmissions > 0 && (x.value == message_damaged
+                                || static_cast < int > (x.value) == state.alt_bit + message_nak_offset);
+                if (negative){
+                    state.answered ++;
+                }
+                if (state.alt_bit == static_cast < int > (x.value)) {
+                    state.ack = true;
+                    state.sending = false;
+                    state.next_internal = TIME();
+                }else if (negative && state.answered == state.transmissions && !state.sending){
+                    // the receiver misses the packet or its ack was damaged, it is sent again now. Every
+                    // transmission is answered once: an answer to an earlier transmission, or one arriving
+                    // while a retransmission is prepared, is stale and the retransmission already goes out
+                    state.sending = true;
+                    state.next_internal = TIME();
+                }
+            }
         }
 
         // confluence transition
         void confluence_transition(TIME e, 
                                    typename make_message_bags<input_ports>::type mbs) {
+            confluence_transition_from(e, mbs);
+        }
+
+        // confluence transition reading bags owned by the caller
+        void confluence_transition_from(TIME e,
+                                        const typename make_message_bags<input_ports>::type &mbs) {
             internal_transition();
-            external_transition(TIME(), std::move(mbs));
+            external_transition_from(TIME(), mbs);
         }
 
         // output function
         typename make_message_bags<output_ports>::type output() const {
             typename make_message_bags<output_ports>::type bags;
+            output_into(bags);
+            return bags;
+        }
+
+        // output function writing into bags reused by the caller, their capacity is kept
+        void output_into(typename make_message_bags<output_ports>::type &bags) const {
+            get_messages<typename defs::packetSentOut>(bags).clear();
+            get_messages<typename defs::ackReceivedOut>(bags).clear();
+            get_messages<typename defs::dataOut>(bags).clear();
             message_t out;
+            out.flow = flow;
             if (state.sending){
                 out.value = state.packet_num * 10 + state.alt_bit;
                 get_messages<typename defs::dataOut>(bags).push_back(out);
@@ -161,7 +296,6 @@ class Sender{
                     get_messages<typename defs::ackReceivedOut>(bags).push_back(out);
                 }
             }   
-            return bags;
         }
 
         // time_advance function
@@ -35,8 +35,66 @@
 #ifndef __SIMULATOR_RENAISSANCE_HPP_
 #define __SIMULATOR_RENAISSANCE_HPP_
 
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "data_structures/bag_policy.hpp"
+
 using namespace std;
 
+/**
+ * @brief      Time-bucketed goodput and latency of a run
+ * The timeline is filled by output_file_evolution while it parses the trace, so the
+ * trace is read once. For every bucket of simulation time it counts the packets
+ * acknowledged (ackReceivedOut), the transmissions and retransmissions (dataOut repeating
+ * the value of the unacknowledged packet), the mean and max delay from the first
+ * transmission of a packet to its ack and the packets dropped by subnet1 and subnet2
+ * (an output of the subnet with an empty bag). Acks and delays count in the bucket of
+ * the ack, transmissions and drops in the bucket they happen in.
+ *
+ * Sample output:
+ * Start,End,Acked,Goodput,Transmissions,Retransmissions,MeanDelay,MaxDelay,Subnet1Drops,Subnet2Drops
+ * 00:00:00:000,00:01:00:000,2,120,3,0,00:00:16:000,00:00:16:000,0,0
+ * 00:01:00:000,00:02:00:000,1,60,2,1,00:00:46:000,00:00:46:000,1,0
+ */
+class trace_timeline{
+    public:
+        /**
+         * @param[in]  i_bucket_ms  Width of a bucket in milliseconds of simulation time
+         */
+        trace_timeline(long long);
+
+        /** Counts a message of the trace, time in HH:MM:SS:mmm */
+        void add(const string &, const string &, const string &, const string &);
+
+        /** Counts a packet dropped by a subnet (subnet1 or subnet2, with or without pair suffix) */
+        void drop(const string &, const string &);
+
+        /** Writes the buckets up to the last one holding an event, goodput in packets per hour */
+        void write(ostream &) const;
+
+    private:
+        struct bucket{
+            long acked = 0;
+            long transmissions = 0;
+            long retransmissions = 0;
+            long long total_delay_ms = 0;
+            long long max_delay_ms = 0;
+            long subnet1_drops = 0;
+            long subnet2_drops = 0;
+        };
+
+        /** Bucket of a time, added if needed */
+        bucket& at(long long);
+
+        long long bucket_ms;
+        vector<bucket> buckets;
+        /** Value and first send time of the unacknowledged packet of every sender */
+        map<string, pair<int, long long>> open_packets;
+};
+
 /**
  * @brief          Function modifies the input file to more readable format 
  *
@@ -45,6 +103,26 @@ using namespace std;
  */
 void output_file_evolution(char *, char *);
 
+/**
+ * @brief          Stream version of output_file_evolution
+ *
+ * @param[in]      i_d_stream   (type istream) The ouput of ABP or test sets, e.g. an in-memory sink
+ * @param[out]     o_d_stream   (type ostream) Receives the readable csv format
+ * @param[out]     timeline     (type trace_timeline) Counts the messages and drops if not null
+ */
+void output_file_evolution(istream &, ostream &, trace_timeline * = nullptr);
+
+/**
+ * @brief          output_file_evolution writing also the timeline of the run
+ * The timeline is computed in the same pass over the trace (see trace_timeline).
+ *
+ * @param[in]      input_file     The input file is the ouput file of ABP or test sets
+ * @param[in]      output_file    The output file is modified to more readable format
+ * @param[in]      timeline_file  The output file containing the timeline
+ * @param[in]      bucket_ms      Width of a bucket of the timeline in milliseconds
+ */
+void output_file_evolution(char *, char *, char *, long long);
+
 /**
  * @brief      String splitter
  * Function returns the  vector string after parsing the input string on the basis
@@ -55,7 +133,7 @@ void output_file_evolution(char *, char *);
  *
  * @return     result String type vector
  */
-vector<string> split(const string &, char *);
+vector<string> split(const string &, char);
 
 /**
  * @brief      Time delay statistics
@@ -66,6 +144,85 @@ vector<string> split(const string &, char *);
  */
 void output_time_statistics(char *, char *);
 
+/**
+ * @brief      Per flow goodput of a shared link run
+ * The function counts the packets delivered (ackReceivedOut) and sent (dataOut) by every
+ * senderk and writes the goodput of each flow in packets per hour of the horizon of the
+ * run, their total and Jain's fairness index.
+ *
+ * @param      input_file   The input file is the ouput file of output_file_evolution
+ * @param      output_file  The output file is file containing the flow statistics
+ * @param      horizon_ms   The end time of the run in milliseconds
+ */
+void output_flow_statistics(char *, char *, long long);
+
+/**
+ * @brief      Per packet delivery report
+ * The function follows every packet of every sender, from its first transmission (dataOut)
+ * to its acknowledgement (ackReceivedOut), and writes at millisecond resolution its first
+ * send time, final ack time, number of transmissions and delay. Packets not acknowledged
+ * by the end of the run have no ack time nor delay. The report ends with the number of
+ * packets, delivered packets, transmissions and retransmissions, the retransmission ratio
+ * (retransmissions / transmissions), the goodput in delivered packets per hour and the
+ * max, min and avg delay.
+ *
+ * Sample output:
+ * Component,Packet,Value,FirstSend,FinalAck,Transmissions,Delay
+ * sender1,1,11,00:00:20:000,00:00:36:000,1,00:00:16:000
+ * sender1,2,20,00:00:46:000,00:01:32:000,2,00:00:46:000
+ * packets,2
+ * ...
+ *
+ * @param      input_file   The input file is the ouput file of output_file_evolution
+ * @param      output_file  The output file is file containing the delivery report
+ */
+void output_delivery_report(char *, char *);
+
+/**
+ * @brief      Stream version of output_delivery_report
+ *
+ * @param[in]  i_d_stream   (type istream) csv of output_file_evolution
+ * @param[out] o_d_stream   (type ostream) Receives the report
+ * @param[in]  packet_rows  false to write only the summary rows
+ */
+void output_delivery_report(istream &, ostream &, bool);
+
+/**
+ * @brief      Per request report of the transfer requests of the control input
+ * A request is a generator_con message asking its sender for N packets. The function
+ * follows every request from its arrival to the first transmission of its first packet
+ * and to the ack of its last one. Senders without queue_requests drop the requests
+ * arriving during a transfer, queueing ones serve them in arrival order. Every row has
+ * the wait (arrival to first send), the completion time (arrival to last ack) and the
+ * status of the request: done, started, waiting or dropped. The report ends with the
+ * number of requests, served (started), done and dropped ones, the longest queue, the
+ * avg and max wait, the avg completion time and the packets of the done requests per
+ * hour of simulated time. Requests arriving at the same time are a bag, the ones after
+ * the first are taken following the bag policy of the senders (see bag_policy.hpp).
+ *
+ * Sample output:
+ * Component,Request,Packets,Arrival,FirstSend,Done,Wait,Completion,Status
+ * sender1,1,2,00:00:10:000,00:00:20:000,00:01:02:000,00:00:10:000,00:00:52:000,done
+ * sender1,2,2,00:00:30:000,,,,,dropped
+ * requests,2
+ * ...
+ *
+ * @param[in]  i_d_stream    (type istream) csv of output_file_evolution
+ * @param[out] o_d_stream    (type ostream) Receives the report
+ * @param[in]  queued        true if the senders queue the requests (Sender::queue_requests)
+ * @param[in]  request_rows  false to write only the summary rows
+ * @param[in]  bags          bag policy of the senders (Sender::bag_handling)
+ */
+void output_request_report(istream &, ostream &, bool, bool, bag_policy = bag_policy::in_order);
+
+/**
+ * @brief      Number of events of a run
+ * The function counts the messages (rows below the header) of a csv of output_file_evolution.
+ *
+ * @param      input_file   The input file is the ouput file of output_file_evolution
+ * @return     Number of messages
+ */
+long count_csv_events(char *);
 
 
 #endif /**< __SIMULATOR_RENAISSANCE_HPP_ */
@@ -2,7 +2,23 @@
  * 
  * The subnet after receiving the message packets sends them after
  * some delay. The probability of subnet is set to 95%, it means that
- * there is a 5% chance of packet loss.
+ * there is a 5% chance of packet loss. With DAMAGE_ON_LOSS a lost packet
+ * still reaches the other end, damaged (message_damaged), so the receiver
+ * of the link can tell that something was lost.
+ * 
+ * A bag of several packets is taken following BAG_HANDLING (see bag_policy.hpp).
+ * In order, the last packet of the bag is the one in transit, as when a packet
+ * arrives during the transit of another one. The packets before it never leave:
+ * they are counted as dropped, and don't use a loss draw or a trace record.
+ * Queued packets are sent one after the other, each once the previous one is out.
+ * Dropped ones are counted.
+ * 
+ * With LINK_TRACE the delay and the loss of every packet are replayed from a
+ * recorded link trace (see link_trace.hpp) instead of being drawn: the next record
+ * of a per packet trace, or the record in effect at the arrival of the packet in a
+ * time indexed one. TRACE_OFFSET skips records, or milliseconds, at the start of the
+ * trace so the subnets replaying one trace don't see the same packets. Past the end of
+ * a trace which doesn't loop (TRACE_LOOP) the packets are drawn again.
  * 
  * It has two phases namely, active state and passive state.
  * When the subnet's status is idle, it is in a passive state. 
@@ -32,8 +48,12 @@
 #include <algorithm>
 #include <limits>
 #include <random>
+#include <deque>
 
 #include "../include/data_structures/message.hpp"
+#include "../include/data_structures/rand_stream.hpp"
+#include "../include/data_structures/bag_policy.hpp"
+#include "../include/link_trace.hpp"
 
 using namespace cadmium;
 using namespace std;
@@ -61,6 +81,11 @@ class Subnet{
     public:
         /**Parameters to be overwriten when instantiating the atomic model
         */
+        bool DAMAGE_ON_LOSS = false; /**< Lost packets are delivered damaged instead of dropped */
+        bag_policy BAG_HANDLING = bag_policy::in_order; /**< Bags of several packets */
+        std::shared_ptr<const link_trace> LINK_TRACE; /**< Recorded delays and losses replayed, null to draw them */
+        long long TRACE_OFFSET = 0;  /**< Records (per packet trace) or milliseconds (time indexed) skipped */
+        bool TRACE_LOOP = false;     /**< The trace starts again from its first record at its end */
 
         /**
          * @brief      Constructor of Subnet Class
@@ -68,8 +93,41 @@ class Subnet{
          * and index to zero
          */
         Subnet() noexcept{
+            reset();
+        }
+
+        /**
+         * @brief      Constructor of Subnet Class with its own loss stream seed
+         * Two subnets of one topology should use different seeds, otherwise
+         * they lose exactly the same packets.
+         * @param[in]  seed  seed of the loss stream
+         */
+        Subnet(unsigned int seed) noexcept{
+            reset(seed);
+        }
+
+        /**
+         * @brief      Puts the subnet back in its initial state
+         * The loss stream restarts from the seed, so a reset subnet loses the
+         * same packets as a new one built with that seed.
+         * @param[in]  seed  seed of the loss stream, 1 as the default constructor
+         */
+        void reset(unsigned int seed = 1) noexcept{
             state.transmiting     = false;
+            state.packet          = 0;
             state.index           = 0;
+            state.flow            = 0;
+            state.delivered       = false;
+            state.pending.clear();
+            state.dropped         = 0;
+            state.replayed        = false;
+            state.delay           = TIME();
+            state.clock           = TIME();
+            state.trace_next      = 0;
+            state.trace_base      = TIME();
+            state.trace_has_current = false;
+            state.trace_released  = 0;
+            state.loss_stream.seed(seed);
         }
 
         /**
@@ -79,7 +137,20 @@ class Subnet{
         struct state_type{
             bool transmiting;
             int packet;
+            int flow;                /**< Flow of the packet in transit */
             int index;
+            bool delivered;          /**< Whether the packet in transit survives the link */
+            rand_stream loss_stream; /**< Per subnet replacement of rand(), seed 1 by default */
+            std::deque<message_t> pending; /**< Packets of bags waiting for the link (bag_policy::queue) */
+            long dropped;            /**< Packets of bags dropped, or overwritten by a later packet of their bag */
+            bool replayed;           /**< The packet in transit has the delay of a trace record */
+            TIME delay;              /**< Its delay */
+            TIME clock;              /**< Time of the last transition, for time indexed traces */
+            size_t trace_next;       /**< Offset of the next record of the trace, 0 before the first packet */
+            TIME trace_base;         /**< Start of the current pass over a looping time indexed trace */
+            link_trace_record trace_current; /**< Record in effect of a time indexed trace */
+            bool trace_has_current;
+            size_t trace_released;   /**< Offset up to which the pages of the trace were released */
         }; 
         state_type state;
         
@@ -90,29 +161,147 @@ class Subnet{
         /**
          * Function that performs the internal transition for the Subnet
          * It takes no input as parameter and resets the subnet transmitting state.
+         * A queued packet of an earlier bag is then put in transit.
         */
         void internal_transition() {
+            state.clock = state.clock + time_advance();
             state.transmiting = false;  
+            if (!state.pending.empty()) {
+                receive(state.pending.front());
+                state.pending.pop_front();
+            }
+        }
+
+        /**
+         * @brief      Puts a packet in transit
+         * The loss of the packet is replayed from the trace, or drawn from the subnet's
+         * own stream, with the probability of 95% it is delivered.
+         * @param[in]  x     the packet
+         */
+        void receive(const message_t &x) {
+            state.packet = static_cast < int > (x.value);
+            state.flow = x.flow;
+            state.transmiting = true; 
+            link_trace_record record;
+            state.replayed = LINK_TRACE && next_trace_record(record);
+            if (state.replayed) {
+                state.delivered = !record.lost;
+                state.delay = ms_time(record.delay_ms);
+            }else {
+                state.delivered = (double)state.loss_stream.next() / (double) RAND_MAX < 0.95;
+            }
+        }
+
+        /**
+         * @brief      Converts milliseconds of a trace to a time
+         */
+        static TIME ms_time(long long ms) {
+            return TIME({static_cast < int > (ms / 3600000), static_cast < int > (ms / 60000 % 60),
+                         static_cast < int > (ms / 1000 % 60), static_cast < int > (ms % 1000)});
+        }
+
+        /**
+         * @brief      Record of the trace for the packet arriving now
+         * The cursor of the subnet only moves forward, the pages it has passed are
+         * released every link_trace_release_bytes.
+         * @param[out] record  the record
+         * @return     false past the end of the trace, or before its first record
+         */
+        bool next_trace_record(link_trace_record &record) {
+            const link_trace &trace = *LINK_TRACE;
+            if (state.trace_next == 0) {
+                state.trace_next = trace.time_indexed() ? trace.first() : trace.skip(trace.first(), TRACE_OFFSET);
+                state.trace_released = trace.first();
+            }
+            bool found = trace.time_indexed() ? timed_record(trace, record) : packet_record(trace, record);
+            if (state.trace_next >= state.trace_released + link_trace_release_bytes) {
+                trace.release(state.trace_released, state.trace_next);
+                state.trace_released = state.trace_next;
+            }
+            return found;
+        }
+
+        /**
+         * @brief      Next record of a per packet trace
+         */
+        bool packet_record(const link_trace &trace, link_trace_record &record) {
+            if (trace.read(state.trace_next, record)) {
+                return true;
+            }
+            if (!TRACE_LOOP) {
+                return false;
+            }
+            state.trace_next = trace.first();
+            state.trace_released = trace.first();
+            return trace.read(state.trace_next, record);
+        }
+
+        /**
+         * @brief      Record of a time indexed trace in effect now
+         * The time in the trace is the time of the subnet plus TRACE_OFFSET, a looping
+         * trace starts a new pass every last_time_ms.
+         */
+        bool timed_record(const link_trace &trace, link_trace_record &record) {
+            const TIME period = ms_time(trace.last_time_ms());
+            TIME now = state.clock + ms_time(TRACE_OFFSET) - state.trace_base;
+            while (TRACE_LOOP && TIME() < period && !(now < period)) {
+                state.trace_base = state.trace_base + period;
+                now = now - period;
+                state.trace_next = trace.first();
+                state.trace_released = trace.first();
+                state.trace_has_current = false;
+            }
+            if (!(now < period)) {
+                return false;
+            }
+            size_t offset = state.trace_next;
+            link_trace_record next;
+            while (trace.read(offset, next) && !(now < ms_time(next.time_ms))) {
+                state.trace_current = next;
+                state.trace_has_current = true;
+                state.trace_next = offset;
+            }
+            record = state.trace_current;
+            return state.trace_has_current;
         }
         
         /**
          * @brief      External Transition Function
-         * Function fetches the message and checks if the number of messages 
-         * is more than 1, then asserts by sending the stated message and 
-         * changes the state to false. It then sets the message value to the packet that is
-         * going to be send and sets the transmitting state to true.
+         * Function fetches the messages and takes them following BAG_HANDLING.
+         * It then sets the message value to the packet that is
+         * going to be send and sets the transmitting state to true. The loss of the packet
+         * is drawn here from the subnet's own stream, with the probability of 95% it
+         * is delivered.
          * @param[in]  e     type time variable
          * @param[in]  mbs   message bags
          */
         void external_transition(TIME e, 
                                  typename make_message_bags<input_ports>::type mbs) { 
+            external_transition_from(e, mbs);
+        }
+
+        /**
+         * @brief      External transition reading bags owned by the caller
+         * Same as external_transition without copying the bags (see flat_kernel.hpp).
+         * @param[in]  e     type time variable
+         * @param[in]  mbs   message bags
+         */
+        void external_transition_from(TIME e,
+                                      const typename make_message_bags<input_ports>::type &mbs) {
             state.index ++;
-            if(get_messages<typename defs::in>(mbs).size()>1){
-                assert(false && "One message at a time");
-            }                
-            for (const auto &x : get_messages<typename defs::in>(mbs)) {
-                state.packet = static_cast < int > (x.value);
-                state.transmiting = true; 
+            state.clock = state.clock + e;
+            const auto &packets = get_messages<typename defs::in>(mbs);
+            for (size_t i = 0; i < packets.size(); i++) {
+                /** In order, only the last packet of the bag is left in transit */
+                if (BAG_HANDLING == bag_policy::in_order && i + 1 < packets.size()) {
+                    state.dropped++;
+                    continue;
+                }
+                switch (bag_policy_action(BAG_HANDLING, i)) {
+                    case bag_action::take: receive(packets[i]); break;
+                    case bag_action::hold: state.pending.push_back(packets[i]); break;
+                    case bag_action::drop: state.dropped++; break;
+                }
             }               
         }
 
@@ -126,25 +315,52 @@ class Subnet{
          */
         void confluence_transition(TIME e, 
                                    typename make_message_bags<input_ports>::type mbs) {
+            confluence_transition_from(e, mbs);
+        }
+
+        /**
+         * @brief      Confluence transition reading bags owned by the caller
+         * @param[in]  e     type time variable
+         * @param[in]  mbs   message bags
+         */
+        void confluence_transition_from(TIME e,
+                                        const typename make_message_bags<input_ports>::type &mbs) {
             internal_transition();
-            external_transition(TIME(), std::move(mbs));
+            external_transition_from(TIME(), mbs);
         }
 
         /**
          * @brief      Messge bag fucntion
          * Function that transmits the message to the output port
-         * The funtion transmits with the probability of 95%. It
+         * The funtion transmits the packets that were drawn as delivered
+         * on arrival, which happens with the probability of 95%. It
          * implies that the packet loss is 5%. 
          * @return     Message bags
          */
         typename make_message_bags<output_ports>::type output() const {
             typename make_message_bags<output_ports>::type bags;
+            output_into(bags);
+            return bags;
+        }
+
+        /**
+         * @brief      Output function writing into bags reused by the caller
+         * The bags are cleared first and keep their capacity, so no memory is
+         * allocated once they have held a message.
+         * @param[out] bags  Message bags
+         */
+        void output_into(typename make_message_bags<output_ports>::type &bags) const {
+            get_messages<typename defs::out>(bags).clear();
             message_t out;
-            if ((double)rand() / (double) RAND_MAX  < 0.95){
+            if (state.delivered){
                 out.value = state.packet;
+                out.flow = state.flow;
+                get_messages<typename defs::out>(bags).push_back(out);
+            }else if (DAMAGE_ON_LOSS){
+                out.value = message_damaged;
+                out.flow = state.flow;
                 get_messages<typename defs::out>(bags).push_back(out);
             }
-            return bags;
         }
 
         
@@ -152,12 +368,16 @@ class Subnet{
          * @brief      Time Advance Function
          * Function sets the next internal transition time.
          * If the current sending state is  true then the next internal 
-         * time is set to value generated by distribution function
+         * time is set to the delay of the trace record of the packet, or to a value
+         * generated by distribution function
          * that provides mean of 3.0 and standard deviation of 1.0, 
          * otherwise it is set to infinity.      
          * @return     next internal time
          */
         TIME time_advance() const {
+            if (state.transmiting && state.replayed) {
+                return state.delay;
+            }
             std::default_random_engine generator;
             std::normal_distribution<double> distribution(3.0, 1.0); 
             TIME next_internal;
@@ -0,0 +1,68 @@
+/** \brief Thread local sink provider for the cadmium loggers
+ *
+ * The sink providers of main.cpp and the tests return one static ofstream, so
+ * every runner of the process writes to the same file. thread_sink_provider
+ * returns the stream installed for the calling thread instead, which lets
+ * several runners log concurrently, each to its own (e.g. in-memory) sink.
+ *
+ * Usage:
+ *      std::ostringstream trace;
+ *      thread_sink_guard guard(trace);
+ *      cadmium::dynamic::engine::runner<NDTime, thread_logger_top<NDTime>> r(TOP, {0});
+ *      r.run_until(NDTime("04:00:00:000"));
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#ifndef __THREAD_SINK_HPP__
+#define __THREAD_SINK_HPP__
+
+#include <iostream>
+
+#include <cadmium/logger/tuple_to_ostream.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+/**
+ * Sink provider returning the stream of the calling thread, std::cout if none is installed
+ */
+struct thread_sink_provider{
+    static std::ostream*& current(){
+        static thread_local std::ostream* stream = &std::cout;
+        return stream;
+    }
+
+    static std::ostream& sink(){
+        return *current();
+    }
+};
+
+/**
+ * @brief      Installs a sink for the calling thread and restores the previous one on destruction
+ */
+class thread_sink_guard{
+    std::ostream* previous;
+    public:
+        thread_sink_guard(std::ostream &sink) : previous(thread_sink_provider::current()) {
+            thread_sink_provider::current() = &sink;
+        }
+        ~thread_sink_guard() {
+            thread_sink_provider::current() = previous;
+        }
+};
+
+/**
+ * Same loggers as logger_top of main.cpp (messages and global time), writing to the thread sink
+ */
+template<typename TIME>
+using thread_logger_top = cadmium::logger::multilogger<
+                              cadmium::logger::logger<cadmium::logger::logger_messages,
+                                  cadmium::dynamic::logger::formatter<TIME>,
+                                  thread_sink_provider>,
+                              cadmium::logger::logger<cadmium::logger::logger_global_time,
+                                  cadmium::dynamic::logger::formatter<TIME>,
+                                  thread_sink_provider>>;
+
+#endif // __THREAD_SINK_HPP__
@@ -0,0 +1,99 @@
+/** \brief This header file contains the capture filters of the trace logger.
+ *
+ * trace_filter_stream is an ostream placed between the cadmium logger and the trace
+ * file (the sink provider returns it instead of the file). It receives the trace line
+ * by line and only forwards what matches the capture filter:
+ *      - a simulation time window [t0, t1]
+ *      - a list of models to include and a list of models to exclude
+ *      - a list of ports, other ports are removed from the message bags
+ *
+ * Lines left without any message ("[] generated by model x") are not written and a
+ * timestamp is only written when at least one of its messages passes, so the size of
+ * the trace follows what is captured. The output stays a valid trace for
+ * output_file_evolution and trace_reader.
+ *
+ * Only the writing of the trace follows what is captured: the cadmium logger has
+ * already formatted every bag, filtered out or not, when the filter receives it, and
+ * the filter still reads every line. The lines are received in blocks (xsputn) and
+ * copied once into the line buffer.
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+#ifndef __TRACE_FILTER_HPP_
+#define __TRACE_FILTER_HPP_
+
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Structure holding the capture filter, an empty list means no restriction
+ */
+struct trace_filter{
+    long long t0_ms = 0;   /**< Start of the time window in milliseconds */
+    long long t1_ms = -1;  /**< End of the time window in milliseconds, -1 for no end */
+    vector<string> include_models;
+    vector<string> exclude_models;
+    vector<string> ports;  /**< Port names without the _defs:: scope, e.g. dataOut */
+
+    /** true if any restriction is set */
+    bool active() const;
+    bool accepts_time(long long) const;
+    bool accepts_model(const string &) const;
+    bool accepts_port(const string &) const;
+};
+
+/**
+ * @brief      Parses a capture option of the command line
+ *
+ * Options are --window t0 t1, --models a,b, --exclude-models a,b and --ports p,q.
+ *
+ * @param[in]     argc, argv  Command line
+ * @param[in,out] i           Index of the option, moved to its last argument
+ * @param[out]    filter      Filter updated with the option
+ * @return        false if argv[i] isn't a capture option or misses its arguments
+ */
+bool parse_trace_filter_option(int, char **, int &, trace_filter &);
+
+/**
+ * @brief      Stream buffer applying a trace_filter line by line
+ */
+class trace_filter_buf : public streambuf{
+    public:
+        trace_filter_buf(ostream &, const trace_filter &);
+
+    protected:
+        int overflow(int) override;
+        streamsize xsputn(const char *, streamsize) override;
+        int sync() override;
+
+    private:
+        ostream &o_d_stream;
+        trace_filter filter;
+        string line;            /**< Line being received */
+        string time;            /**< Last timestamp line */
+        long long time_ms = 0;
+        bool time_written = false;
+
+        void process_line();
+        string filter_ports(const string &, size_t);
+};
+
+/**
+ * @brief      Output stream writing the filtered trace to another stream
+ */
+class trace_filter_stream : public ostream{
+    public:
+        trace_filter_stream(ostream &, const trace_filter &);
+
+    private:
+        trace_filter_buf buf;
+};
+
+#endif /**< __TRACE_FILTER_HPP_ */
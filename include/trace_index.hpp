@@ -0,0 +1,123 @@
+/** \brief This header file contains the sparse time index of the simulator traces.
+ *
+ * Looking at a time range of a large raw trace (abp_output.txt) means reading it from
+ * its start. A trace index records the byte offset of every Nth timestamp line of the
+ * trace, so a reader can seek close to a time and read only from there. The index is a
+ * small csv written next to the trace (abp_output.txt.idx):
+ *      Time,Offset
+ *      00:00:00:000,0
+ *      00:12:40:000,1048710
+ * It is built in one pass over an existing trace (build_trace_index), or written while
+ * the trace is logged by placing trace_index_stream between the logger and the file.
+ * Timestamps are never decreasing in a trace, so every message at or after a time t
+ * follows the last indexed timestamp before t (trace_index_seek).
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+#ifndef __TRACE_INDEX_HPP_
+#define __TRACE_INDEX_HPP_
+
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "trace_filter.hpp"
+
+using namespace std;
+
+/** Timestamps between two entries of an index by default */
+const long trace_index_default_every = 1000;
+
+/**
+ * Structure holding an entry of the index
+ */
+struct trace_index_entry{
+    long long time_ms;
+    long long offset;   /**< Byte offset of the timestamp line in the trace */
+};
+
+/**
+ * @brief      Stream buffer passing a raw trace through and indexing its timestamps
+ */
+class trace_index_buf : public streambuf{
+    public:
+        /**
+         * @param[out] o_trace  stream receiving the trace, nullptr to only index it
+         * @param[out] o_index  stream receiving the index
+         * @param[in]  every    a timestamp line out of every is indexed
+         */
+        trace_index_buf(ostream *, ostream &, long);
+
+        /** Timestamp lines received */
+        long long timestamp_count() const;
+
+    protected:
+        int overflow(int) override;
+        streamsize xsputn(const char *, streamsize) override;
+        int sync() override;
+
+    private:
+        ostream *o_trace;
+        ostream &o_index;
+        long every;
+        long long offset = 0;       /**< Bytes received */
+        long long line_offset = 0;  /**< Offset of the line being received */
+        long long timestamps = 0;
+        bool bag_line = false;      /**< The line being received is a message line */
+        string line;                /**< Line being received, only kept for timestamp lines */
+
+        void scan(char);
+};
+
+/**
+ * @brief      Output stream writing a trace to another stream and its index to a third one
+ */
+class trace_index_stream : public ostream{
+    public:
+        trace_index_stream(ostream &, ostream &, long = trace_index_default_every);
+
+    private:
+        trace_index_buf buf;
+};
+
+/**
+ * @brief      Indexes an existing raw trace in one pass
+ *
+ * @param[in]  i_trace  the raw trace
+ * @param[out] o_index  stream receiving the index
+ * @param[in]  every    a timestamp line out of every is indexed
+ * @return     Number of timestamp lines of the trace
+ */
+long long build_trace_index(istream &, ostream &, long = trace_index_default_every);
+
+/**
+ * @brief      Reads an index written by trace_index_stream or build_trace_index
+ */
+vector<trace_index_entry> read_trace_index(istream &);
+
+/**
+ * @brief      Offset to read the trace from to get every message at or after a time
+ *
+ * @return     Offset of the last indexed timestamp before the time, 0 if none
+ */
+long long trace_index_seek(const vector<trace_index_entry> &, long long);
+
+/**
+ * @brief      Writes the part of a raw trace in the time window of a filter
+ *
+ * The trace is read from the offset until its first timestamp after the window, the
+ * lines go through a trace_filter_stream (window, models and ports) to the output.
+ *
+ * @param[in]  i_trace  the raw trace, seekable
+ * @param[in]  offset   where to start reading, see trace_index_seek
+ * @param[in]  filter   window and models to keep
+ * @param[out] o_slice  stream receiving the raw slice
+ * @return     Bytes of the trace read
+ */
+long long slice_trace(istream &, long long, const trace_filter &, ostream &);
+
+#endif /**< __TRACE_INDEX_HPP_ */
@@ -0,0 +1,106 @@
+/** \brief This header file contains a streaming reader for simulator traces.
+ *
+ * trace_reader reads the messages of a trace one timestamp at a time, whether the
+ * trace is the raw output of the cadmium logger (abp_output.txt) or the csv produced
+ * by output_file_evolution (file_mod_output.csv). The format is detected from the
+ * first line. Only the messages of the current timestamp are held in memory, so
+ * traces of any size are read in constant memory.
+ *
+ * Every message becomes a trace_record with the same fields as a row of the csv:
+ *      Time,Value,Port,Component
+ *      00:00:20:000,11,dataOut,sender1
+ *
+ * Several messages on one port (e.g. {11, 20}) become several records. Empty
+ * bags are skipped. All steps of the simulator sharing one timestamp are read
+ * as one bag, their order is not kept.
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+#ifndef __TRACE_READER_HPP_
+#define __TRACE_READER_HPP_
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Structure holding one message of the trace
+ */
+struct trace_record{
+    string time;       /**< Time as written in the trace, HH:MM:SS:mmm */
+    long long time_ms; /**< Time in milliseconds */
+    string value;
+    string port;       /**< Port name without the _defs:: scope */
+    string component;  /**< Model which generated the message */
+};
+
+/**
+ * @brief      Records are ordered by component, port and value, time is not compared
+ */
+bool operator<(const trace_record &, const trace_record &);
+bool operator==(const trace_record &, const trace_record &);
+
+/**
+ * @brief      Converts a trace time (HH:MM:SS:mmm, or HH:MM:SS) to milliseconds
+ *
+ * @return     Milliseconds, -1 if the string is not a time
+ */
+long long parse_time_ms(const string &);
+
+/**
+ * @brief      Converts milliseconds to a trace time HH:MM:SS:mmm
+ */
+string format_time_ms(long long);
+
+/**
+ * @brief      Class reading a trace one timestamp at a time
+ */
+class trace_reader{
+    public:
+        /**
+         * @param[in]  i_d_stream  Raw trace or csv, the format is detected on the first read
+         */
+        trace_reader(istream &);
+
+        /**
+         * @brief      Reads the messages of the next timestamp which has any
+         *
+         * @param[out] time     Time of the bag as written in the trace
+         * @param[out] records  Messages of the bag, replaced on every call
+         * @return     false at the end of the trace
+         */
+        bool next_bag(string &, vector<trace_record> &);
+
+        /**
+         * @brief      Reads the next message
+         *
+         * @param[out] record  The message
+         * @return     false at the end of the trace
+         */
+        bool next_record(trace_record &);
+
+        /** true if the trace is a csv of output_file_evolution */
+        bool is_csv() const;
+
+    private:
+        istream &i_d_stream;
+        bool format_known = false;
+        bool csv = false;
+        string time;                  /**< Time of the last timestamp line of a raw trace */
+        long long time_ms = 0;
+        vector<trace_record> pending; /**< Records parsed from the current line, not returned yet */
+        size_t pending_pos = 0;
+        bool has_lookahead = false;   /**< A record of the next bag was read by next_bag */
+        trace_record lookahead;
+
+        bool read_line_records();
+        void parse_raw_line(const string &);
+        void parse_csv_line(const string &);
+};
+
+#endif /**< __TRACE_READER_HPP_ */
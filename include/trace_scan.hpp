@@ -0,0 +1,227 @@
+/** \brief This header file contains the scanning kernels of the trace parsers.
+ *
+ * The parsers of simulator_renaissance.cpp look for the commas, braces, colons and
+ * brackets of a line with one std::string::find per character and convert the times
+ * with split and stoi. scan_trace_line finds all the structural characters of a line
+ * in one pass, comparing 16 (SSE2) or 32 (AVX2) bytes at once and only visiting the
+ * bytes which matched, and parse_fixed_time_ms converts a HH:MM:SS:mmm time to
+ * milliseconds without a branch.
+ *
+ * The kernels are inline so they are compiled into the loops of their callers. The
+ * AVX2 kernel is chosen at run time when the processor has it, the SSE2 one is the
+ * baseline of x86-64 and other processors use the scalar loop.
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+#ifndef __TRACE_SCAN_HPP_
+#define __TRACE_SCAN_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TRACE_SCAN_X86 1
+#endif
+
+using namespace std;
+
+/**
+ * Kernels of scan_trace_line
+ */
+enum class trace_scan_isa{
+    scalar,
+    sse2,
+    avx2
+};
+
+/**
+ * Structure holding the positions of the structural characters of a line, in order
+ */
+struct trace_line_scan{
+    vector<uint32_t> commas;        /**< ',' */
+    vector<uint32_t> braces_open;   /**< '{' */
+    vector<uint32_t> braces_close;  /**< '}' */
+    vector<uint32_t> colons;        /**< ':' */
+    vector<uint32_t> squares_open;  /**< '[' */
+    vector<uint32_t> squares_close; /**< ']' */
+
+    void clear() {
+        commas.clear();
+        braces_open.clear();
+        braces_close.clear();
+        colons.clear();
+        squares_open.clear();
+        squares_close.clear();
+    }
+};
+
+/**
+ * @brief      Records the structural character at a position, if it is one
+ */
+inline void trace_scan_byte(const char *s, uint32_t i, trace_line_scan &scan) {
+    switch (s[i]) {
+        case ',': scan.commas.push_back(i); break;
+        case '{': scan.braces_open.push_back(i); break;
+        case '}': scan.braces_close.push_back(i); break;
+        case ':': scan.colons.push_back(i); break;
+        case '[': scan.squares_open.push_back(i); break;
+        case ']': scan.squares_close.push_back(i); break;
+        default: break;
+    }
+}
+
+/**
+ * @brief      Records the bytes of a block whose bit is set in a mask
+ */
+inline void trace_scan_mask(const char *s, uint32_t base, uint32_t mask, trace_line_scan &scan) {
+    while (mask != 0) {
+        trace_scan_byte(s, base + __builtin_ctz(mask), scan);
+        mask &= mask - 1;
+    }
+}
+
+inline void trace_scan_scalar(const char *s, size_t n, size_t from, trace_line_scan &scan) {
+    for (size_t i = from; i < n; i++) {
+        trace_scan_byte(s, (uint32_t) i, scan);
+    }
+}
+
+#ifdef TRACE_SCAN_X86
+/**
+ * @brief      Scans the line 16 bytes at a time
+ *
+ * The bytes of a block are compared with the six characters and a mask of the
+ * bytes which matched is extracted. Most blocks of a trace line (port names, model
+ * names) have no match and cost six compares. Lines are short, so their last bytes
+ * are scanned as one more block instead of byte by byte.
+ */
+inline void trace_scan_sse2(const char *s, size_t n, trace_line_scan &scan) {
+    const __m128i comma = _mm_set1_epi8(','), brace_open = _mm_set1_epi8('{'), brace_close = _mm_set1_epi8('}'),
+                  colon = _mm_set1_epi8(':'), square_open = _mm_set1_epi8('['), square_close = _mm_set1_epi8(']');
+    char tail[16];
+    for (size_t i = 0; i < n; i += 16) {
+        const char *bytes = s + i;
+        /** The last bytes are copied to a zeroed block, so the line is never read past its end */
+        if (i + 16 > n) {
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, s + i, n - i);
+            bytes = tail;
+        }
+        __m128i block = _mm_loadu_si128((const __m128i *) bytes);
+        __m128i match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, comma), _mm_cmpeq_epi8(block, colon)),
+                        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, brace_open), _mm_cmpeq_epi8(block, brace_close)),
+                        _mm_or_si128(_mm_cmpeq_epi8(block, square_open), _mm_cmpeq_epi8(block, square_close))));
+        trace_scan_mask(s, (uint32_t) i, (uint32_t) _mm_movemask_epi8(match), scan);
+    }
+}
+
+/**
+ * @brief      Same as trace_scan_sse2 with 32 byte blocks
+ */
+__attribute__((target("avx2")))
+inline void trace_scan_avx2(const char *s, size_t n, trace_line_scan &scan) {
+    const __m256i comma = _mm256_set1_epi8(','), brace_open = _mm256_set1_epi8('{'),
+                  brace_close = _mm256_set1_epi8('}'), colon = _mm256_set1_epi8(':'),
+                  square_open = _mm256_set1_epi8('['), square_close = _mm256_set1_epi8(']');
+    char tail[32];
+    for (size_t i = 0; i < n; i += 32) {
+        const char *bytes = s + i;
+        if (i + 32 > n) {
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, s + i, n - i);
+            bytes = tail;
+        }
+        __m256i block = _mm256_loadu_si256((const __m256i *) bytes);
+        __m256i match = _mm256_or_si256(
+                        _mm256_or_si256(_mm256_cmpeq_epi8(block, comma), _mm256_cmpeq_epi8(block, colon)),
+                        _mm256_or_si256(
+                            _mm256_or_si256(_mm256_cmpeq_epi8(block, brace_open), _mm256_cmpeq_epi8(block, brace_close)),
+                            _mm256_or_si256(_mm256_cmpeq_epi8(block, square_open), _mm256_cmpeq_epi8(block, square_close))));
+        trace_scan_mask(s, (uint32_t) i, (uint32_t) _mm256_movemask_epi8(match), scan);
+    }
+}
+#endif
+
+/**
+ * @brief      Widest kernel of the processor, checked once
+ */
+inline trace_scan_isa trace_scan_best_isa() {
+#ifdef TRACE_SCAN_X86
+    static const trace_scan_isa best = __builtin_cpu_supports("avx2") ? trace_scan_isa::avx2 : trace_scan_isa::sse2;
+    return best;
+#else
+    return trace_scan_isa::scalar;
+#endif
+}
+
+/**
+ * @brief      Finds the structural characters of a line
+ *
+ * @param[in]  s     the line
+ * @param[in]  n     its length
+ * @param[out] scan  cleared and filled with the positions of the characters
+ * @param[in]  isa   kernel to use, an unavailable one falls back to the scalar loop
+ */
+inline void scan_trace_line(const char *s, size_t n, trace_line_scan &scan,
+                            trace_scan_isa isa = trace_scan_best_isa()) {
+    scan.clear();
+#ifdef TRACE_SCAN_X86
+    if (isa == trace_scan_isa::avx2) {
+        trace_scan_avx2(s, n, scan);
+        return;
+    }
+    if (isa == trace_scan_isa::sse2) {
+        trace_scan_sse2(s, n, scan);
+        return;
+    }
+#endif
+    trace_scan_scalar(s, n, 0, scan);
+}
+
+/**
+ * @brief      First position of a list at or after a position
+ * @return     The position, SIZE_MAX (std::string::npos) if there is none
+ */
+inline size_t trace_scan_next(const vector<uint32_t> &positions, size_t from) {
+    size_t low = 0, high = positions.size();
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (positions[middle] < from) {
+            low = middle + 1;
+        }else {
+            high = middle;
+        }
+    }
+    return (low == positions.size()) ? SIZE_MAX : positions[low];
+}
+
+/**
+ * @brief      Converts a fixed width HH:MM:SS:mmm time to milliseconds
+ *
+ * The twelve characters are converted and checked with arithmetic only, the result
+ * is selected with a mask instead of a branch. The minutes and seconds aren't range
+ * checked, like the split and stoi conversion it replaces.
+ *
+ * @param[in]  s     at least 12 characters
+ * @return     Milliseconds, -1 if the characters aren't a time
+ */
+inline long long parse_fixed_time_ms(const char *s) {
+    const unsigned char *u = (const unsigned char *) s;
+    unsigned h1 = u[0] - '0', h0 = u[1] - '0', m1 = u[3] - '0', m0 = u[4] - '0', s1 = u[6] - '0', s0 = u[7] - '0',
+             ms2 = u[9] - '0', ms1 = u[10] - '0', ms0 = u[11] - '0';
+    /** A byte below '0' wraps to a large unsigned value, so one compare checks a digit */
+    unsigned bad = (h1 > 9) | (h0 > 9) | (m1 > 9) | (m0 > 9) | (s1 > 9) | (s0 > 9) | (ms2 > 9) | (ms1 > 9) | (ms0 > 9)
+                   | (u[2] != ':') | (u[5] != ':') | (u[8] != ':');
+    long long ms = (((long long) (h1 * 10 + h0) * 60 + (m1 * 10 + m0)) * 60 + (s1 * 10 + s0)) * 1000
+                   + ms2 * 100 + ms1 * 10 + ms0;
+    long long valid = -(long long) (bad == 0);
+    return (ms & valid) | ~valid;
+}
+
+#endif /**< __TRACE_SCAN_HPP_ */
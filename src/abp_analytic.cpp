@@ -0,0 +1,232 @@
+/** \brief Analytical delay and throughput of the ABP simulator, cross-checked against simulation
+ *
+ * ABP_ANALYTIC solves the chain of abp_markov.hpp for the given parameters and prints the
+ * mean delay, its standard deviation and distribution, the mean number of transmissions
+ * and the throughput of a sender never idle, in microseconds instead of a simulation.
+ * The link delay defaults to the one of the Subnet model.
+ *
+ * --check compares the packets of a delivery report (output_delivery_report) with the
+ * chain, --simulate runs N replications of the simulator with the same parameters and
+ * compares their packets. Packets whose delay the chain can't give (e.g. a control
+ * message reaching the sender in the middle of a packet restarts its timer) are counted
+ * apart, the others are compared with the distribution of the chain. The default control
+ * input, data/input_abp_0.txt, sends one batch of packets, so none of them is disturbed.
+ *
+ * Usage: ./bin/ABP_ANALYTIC [--preparation t] [--timeout t] [--ack-preparation t] [--loss 0.05]
+ *                           [--link-delay ms | ms:p,ms:p,...] [--threshold t] [--rows 10]
+ *                           [--check delivery_report.csv] [--simulate N [control input] [horizon]]
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <chrono>
+#include <cstdlib>
+
+#include "../lib/DESTimes/include/NDTime.hpp"
+
+#include "../include/abp_markov.hpp"
+#include "../include/abp_runner.hpp"
+#include "../include/simulator_renaissance.hpp"
+#include "../include/trace_reader.hpp"
+
+using namespace std;
+
+using hclock=chrono::high_resolution_clock;
+using TIME = NDTime;
+
+/**
+ * @brief      Delay of the Subnet model in milliseconds
+ */
+static long long subnet_delay_ms() {
+    Subnet<TIME> subnet;
+    subnet.state.transmiting = true;
+    ostringstream delay;
+    delay << subnet.time_advance();
+    return parse_time_ms(delay.str());
+}
+
+/**
+ * @brief      Reads the delays of the acked packets of a delivery report
+ */
+static void read_report_delays(istream &report, vector<long long> &delays) {
+    string line;
+    while (getline(report, line)) {
+        vector<string> fields = split(line, ',');
+        if (fields.size() == 7 && fields[0] != "Component" && !fields[6].empty()) {
+            delays.push_back(parse_time_ms(fields[6]));
+        }
+    }
+}
+
+/**
+ * @brief      Compares the delays of simulated packets with the chain
+ * @return     0 if the mean delay of the packets of the chain is within its 95% interval
+ */
+static int compare_delays(const vector<long long> &delays, const abp_chain_solution &solution, int rows) {
+    map<long long, long long> counts;
+    long long inside = 0;
+    double sum = 0, square = 0;
+    for (long long delay : delays) {
+        if (solution.delay_pmf.count(delay) != 0) {
+            counts[delay]++;
+            inside++;
+            sum += delay;
+            square += (double) delay * delay;
+        }
+    }
+    long long outside = delays.size() - inside;
+    cout << delays.size() << " simulated packets, " << outside << " with a delay the chain can't give" << endl;
+    if (inside < 2) {
+        cout << "too few packets to compare" << endl;
+        return 1;
+    }
+    double mean = sum / inside;
+    double half_width = 1.96 * sqrt((square - sum * mean) / (inside - 1) / inside);
+    double distance = 0;
+    for (const auto &delay : solution.delay_pmf) {
+        distance += fabs(delay.second - (double) counts[delay.first] / inside);
+    }
+    cout << "Delay,Analytic,Simulated" << endl;
+    int row = 0;
+    for (const auto &delay : solution.delay_pmf) {
+        if (row++ >= rows) {
+            break;
+        }
+        cout << format_time_ms(delay.first) << "," << delay.second << "," << (double) counts[delay.first] / inside << endl;
+    }
+    bool agrees = fabs(mean - solution.mean_delay_ms) <= half_width;
+    cout << "mean delay: analytic " << solution.mean_delay_ms << " ms, simulated " << mean << " +- " << half_width
+         << " ms (" << (agrees ? "agrees" : "differs") << "), total variation distance " << distance / 2 << endl;
+    return agrees ? 0 : 1;
+}
+
+/**\brief  main function
+ *
+ * @param argc Integer argument - These are counting the command line arguments
+ * @param argv Argument vector - parameters of the chain and cross-check options
+ */
+int main(int argc, char ** argv){
+
+    abp_chain_parameters parameters;
+    string threshold, check_file, input = "data/input_abp_0.txt", horizon = "04:00:00:000";
+    string link_delay;
+    int rows = 10;
+    int simulate = 0;
+    bool valid = true;
+    for (int i = 1; i < argc && valid; i++) {
+        string option = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (option == "--preparation" && has_value) {
+            parameters.sender_preparation_ms = parse_time_ms(argv[++i]);
+        }else if (option == "--timeout" && has_value) {
+            parameters.timeout_ms = parse_time_ms(argv[++i]);
+        }else if (option == "--ack-preparation" && has_value) {
+            parameters.receiver_preparation_ms = parse_time_ms(argv[++i]);
+        }else if (option == "--loss" && has_value) {
+            parameters.loss = atof(argv[++i]);
+        }else if (option == "--link-delay" && has_value) {
+            link_delay = argv[++i];
+        }else if (option == "--threshold" && has_value) {
+            threshold = argv[++i];
+        }else if (option == "--rows" && has_value) {
+            rows = atoi(argv[++i]);
+        }else if (option == "--check" && has_value) {
+            check_file = argv[++i];
+        }else if (option == "--simulate" && has_value) {
+            simulate = atoi(argv[++i]);
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                input = argv[++i];
+            }
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                horizon = argv[++i];
+            }
+        }else {
+            valid = false;
+        }
+    }
+    if (link_delay.empty()) {
+        parameters.link_delay_ms = {{subnet_delay_ms(), 1.0}};
+    }else {
+        parameters.link_delay_ms.clear();
+        for (const string &value : split(link_delay, ',')) {
+            vector<string> pair = split(value, ':');
+            parameters.link_delay_ms[atoll(pair[0].c_str())] += (pair.size() > 1) ? atof(pair[1].c_str()) : 1.0;
+        }
+    }
+    valid = valid && parameters.sender_preparation_ms >= 0 && parameters.timeout_ms >= 0
+            && parameters.receiver_preparation_ms >= 0 && (threshold.empty() || parse_time_ms(threshold) >= 0);
+    if (!valid) {
+        cout << "you are using this program with wrong parameters. The program should be invoked as follow:";
+        cout << argv[0] << " [--preparation t] [--timeout t] [--ack-preparation t] [--loss 0.05]"
+             << " [--link-delay ms | ms:p,...] [--threshold t] [--rows 10] [--check delivery report]"
+             << " [--simulate N [control input] [horizon]]" << endl;
+        return 1;
+    }
+
+    auto start = hclock::now();
+    abp_chain_solution solution = solve_abp_chain(parameters);
+    double usecs = chrono::duration_cast<chrono::duration<double, micro>>(hclock::now() - start).count();
+    if (!solution.applicable) {
+        cout << "the chain doesn't apply: " << solution.reason << endl;
+        return 1;
+    }
+    cout << "solved in " << usecs << " usec" << endl;
+    cout << "attempt success " << solution.success << ", transmissions per packet " << solution.mean_transmissions
+         << endl;
+    cout << "mean delay " << solution.mean_delay_ms << " ms, standard deviation " << solution.delay_std_ms
+         << " ms, median " << format_time_ms(solution.quantile(0.5)) << ", 99th percentile "
+         << format_time_ms(solution.quantile(0.99)) << endl;
+    cout << "throughput of a sender never idle " << solution.throughput_per_hour << " packets/hour" << endl;
+    if (!threshold.empty()) {
+        cout << "P(delay > " << threshold << ") = " << solution.tail(parse_time_ms(threshold)) << endl;
+    }
+
+    int status = 0;
+    if (!check_file.empty()) {
+        ifstream report(check_file);
+        if (!report) {
+            cout << "can't read " << check_file << endl;
+            return 1;
+        }
+        vector<long long> delays;
+        read_report_delays(report, delays);
+        status |= compare_delays(delays, solution, rows);
+    }
+    if (simulate > 0) {
+        /** The subnets of the simulator lose 5% of the messages with the delay of subnet_delay_ms */
+        abp_parameters<TIME> run_parameters;
+        run_parameters.sender_preparation = TIME(format_time_ms(parameters.sender_preparation_ms).c_str());
+        run_parameters.sender_timeout = TIME(format_time_ms(parameters.timeout_ms).c_str());
+        run_parameters.receiver_preparation = TIME(format_time_ms(parameters.receiver_preparation_ms).c_str());
+        abp_runner<TIME> runner;
+        vector<long long> delays;
+        auto simulation_start = hclock::now();
+        for (int r = 1; r <= simulate; r++) {
+            run_parameters.seed = r;
+            ostringstream trace;
+            runner.run(input.c_str(), TIME(horizon.c_str()), &trace, run_parameters);
+            istringstream trace_stream(trace.str());
+            ostringstream csv;
+            output_file_evolution(trace_stream, csv);
+            istringstream csv_stream(csv.str());
+            ostringstream report;
+            output_delivery_report(csv_stream, report, true);
+            istringstream report_stream(report.str());
+            read_report_delays(report_stream, delays);
+        }
+        double secs = chrono::duration_cast<chrono::duration<double, ratio<1>>>(hclock::now() - simulation_start).count();
+        cout << simulate << " replications of " << input << " simulated in " << secs << "sec" << endl;
+        status |= compare_delays(delays, solution, rows);
+    }
+    return status;
+}
@@ -0,0 +1,229 @@
+/** /brief This source file contains the batch mode of the ABP simulator.
+ *
+ * See abp_batch.hpp. The runs are shared by the threads through an atomic index,
+ * every thread keeps one abp_runner and writes the outputs of its runs with the
+ * file versions of the functions of simulator_renaissance.
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cerrno>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "../lib/DESTimes/include/NDTime.hpp"
+
+#include "../include/abp_batch.hpp"
+#include "../include/abp_runner.hpp"
+#include "../include/simulator_renaissance.hpp"
+
+using namespace std;
+
+using hclock=chrono::high_resolution_clock;
+using TIME = NDTime;
+
+/**
+ * Structure holding the outcome of a run of the batch
+ */
+struct batch_run{
+    string input;
+    string name;
+    string output_dir;
+    bool done = false;
+    long events = 0;
+    double secs = 0;
+    map<string, string> summary;  /**< Summary rows of the delivery report */
+};
+
+static bool is_regular_file(const string &path) {
+    struct stat stat_buff;
+    return stat(path.c_str(), &stat_buff) == 0 && S_ISREG(stat_buff.st_mode);
+}
+
+static bool is_directory(const string &path) {
+    struct stat stat_buff;
+    return stat(path.c_str(), &stat_buff) == 0 && S_ISDIR(stat_buff.st_mode);
+}
+
+/**
+ * @brief      Creates a directory and its parents
+ */
+static bool make_directories(const string &path) {
+    for (size_t slash = path.find('/', 1); ; slash = path.find('/', slash + 1)) {
+        string prefix = path.substr(0, slash);
+        if (!prefix.empty() && !is_directory(prefix) && mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) {
+            return false;
+        }
+        if (slash == string::npos) {
+            return true;
+        }
+    }
+}
+
+/**
+ * @brief      File name of a path without its directory and extension
+ */
+static string input_name(const string &path) {
+    size_t slash = path.find_last_of('/');
+    string name = (slash == string::npos) ? path : path.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    return (dot == string::npos || dot == 0) ? name : name.substr(0, dot);
+}
+
+vector<string> batch_inputs(const string &spec) {
+    vector<string> inputs;
+    if (is_directory(spec)) {
+        DIR *dir = opendir(spec.c_str());
+        if (dir == nullptr) {
+            return inputs;
+        }
+        while (dirent *entry = readdir(dir)) {
+            string file = entry->d_name;
+            string path = spec + "/" + file;
+            if (file.compare(0, 5, "input") == 0 && file.size() > 4 && file.compare(file.size() - 4, 4, ".txt") == 0
+                && is_regular_file(path)) {
+                inputs.push_back(path);
+            }
+        }
+        closedir(dir);
+        sort(inputs.begin(), inputs.end());
+    }else if (spec.find(',') != string::npos) {
+        for (const string &input : split(spec, ',')) {
+            if (!input.empty()) {
+                inputs.push_back(input);
+            }
+        }
+    }else if (is_regular_file(spec)) {
+        /** A list file names one existing file per line, a control input doesn't */
+        ifstream i_d_stream(spec);
+        string line;
+        bool list = false;
+        while (getline(i_d_stream, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (line.empty()) {
+                continue;
+            }
+            list = is_regular_file(line);
+            if (!list) {
+                break;
+            }
+            inputs.push_back(line);
+        }
+        if (!list) {
+            inputs.assign(1, spec);
+        }
+    }
+    return inputs;
+}
+
+/**
+ * @brief      Runs one input of the batch and writes its outputs
+ */
+static void run_one(batch_run &run, abp_runner<TIME> &runner, const string &end_time, long long bucket_ms) {
+    auto start = hclock::now();
+    if (!is_regular_file(run.input) || !make_directories(run.output_dir)) {
+        cout << run.input << ": can't run it into " << run.output_dir << endl;
+        return;
+    }
+    string trace_path = run.output_dir + "/abp_output.txt";
+    string mod_output_path = run.output_dir + "/file_mod_output.csv";
+    string time_statistics_path = run.output_dir + "/time_stats_output.csv";
+    string delivery_report_path = run.output_dir + "/delivery_report.csv";
+    string timeline_path = run.output_dir + "/timeline.csv";
+    {
+        ofstream out_data(trace_path);
+        runner.run(run.input.c_str(), TIME(end_time.c_str()), &out_data);
+    }
+    output_file_evolution(&trace_path[0], &mod_output_path[0], &timeline_path[0], bucket_ms);
+    output_time_statistics(&mod_output_path[0], &time_statistics_path[0]);
+    output_delivery_report(&mod_output_path[0], &delivery_report_path[0]);
+    run.events = count_csv_events(&mod_output_path[0]);
+
+    /** The summary rows are the rows of the report with two fields */
+    ifstream report(delivery_report_path);
+    string line;
+    while (getline(report, line)) {
+        vector<string> fields = split(line, ',');
+        if (fields.size() == 2) {
+            run.summary[fields[0]] = fields[1];
+        }
+    }
+    run.secs = chrono::duration_cast<chrono::duration<double, ratio<1>>>(hclock::now() - start).count();
+    run.done = true;
+}
+
+int run_batch(const vector<string> &inputs, const string &end_time, const string &output_template,
+              const string &summary_file, int threads, long long bucket_ms) {
+    if (output_template.find("{name}") == string::npos && inputs.size() > 1) {
+        cout << "the output directory template must contain {name}" << endl;
+        return 1;
+    }
+    vector<batch_run> runs(inputs.size());
+    set<string> names;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        runs[i].input = inputs[i];
+        runs[i].name = input_name(inputs[i]);
+        /** Inputs of the same name in different directories get their index appended */
+        if (!names.insert(runs[i].name).second) {
+            runs[i].name += "_" + to_string(i);
+            names.insert(runs[i].name);
+        }
+        runs[i].output_dir = output_template;
+        for (size_t at = runs[i].output_dir.find("{name}"); at != string::npos;
+             at = runs[i].output_dir.find("{name}", at)) {
+            runs[i].output_dir.replace(at, 6, runs[i].name);
+        }
+    }
+
+    auto start = hclock::now();
+    atomic<size_t> next_run(0);
+    vector<thread> workers;
+    for (int t = 0; t < max(1, min(threads, (int) runs.size())); t++) {
+        workers.emplace_back([&]() {
+            abp_runner<TIME> runner;
+            for (size_t i = next_run++; i < runs.size(); i = next_run++) {
+                run_one(runs[i], runner, end_time, bucket_ms);
+            }
+        });
+    }
+    for (thread &worker : workers) {
+        worker.join();
+    }
+    double secs = chrono::duration_cast<chrono::duration<double, ratio<1>>>(hclock::now() - start).count();
+
+    size_t slash = summary_file.find_last_of('/');
+    if (slash != string::npos) {
+        make_directories(summary_file.substr(0, slash));
+    }
+    ofstream summary(summary_file, ofstream::out | ofstream::trunc);
+    summary << "Input,Events,Packets,Delivered,Transmissions,Retransmissions,RetransmissionRatio,"
+            << "Goodput,MaxDelay,MinDelay,AvgDelay,Secs" << endl;
+    bool all_done = true;
+    for (batch_run &run : runs) {
+        all_done &= run.done;
+        summary << run.input << "," << run.events << "," << run.summary["packets"] << ","
+                << run.summary["delivered"] << "," << run.summary["transmissions"] << ","
+                << run.summary["retransmissions"] << "," << run.summary["retransmission_ratio"] << ","
+                << run.summary["goodput"] << "," << run.summary["max"] << "," << run.summary["min"] << ","
+                << run.summary["avg"] << "," << run.secs << endl;
+    }
+    cout << runs.size() << " runs took " << secs << "sec on " << workers.size() << " threads, summary written to "
+         << summary_file << endl;
+    return all_done ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+/** /brief This source file contains the analytical model of the ABP simulator.
+ *
+ * See abp_markov.hpp. The distribution of the delay is the one of the round trip
+ * (the link delay convolved with itself, shifted by the receiver preparation) repeated
+ * at every number of failed attempts, weighted by the geometric law of K. It is built
+ * until the probability left is below the requested tail mass.
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#include <string>
+#include <map>
+#include <cmath>
+#include <algorithm>
+
+#include "../include/abp_markov.hpp"
+
+using namespace std;
+
+double abp_chain_solution::tail(long long ms) const {
+    double above = truncated;
+    for (auto it = delay_pmf.upper_bound(ms); it != delay_pmf.end(); ++it) {
+        above += it->second;
+    }
+    return above;
+}
+
+long long abp_chain_solution::quantile(double p) const {
+    double cumulative = 0;
+    for (const auto &delay : delay_pmf) {
+        cumulative += delay.second;
+        if (cumulative >= p) {
+            return delay.first;
+        }
+    }
+    return delay_pmf.empty() ? 0 : delay_pmf.rbegin()->first;
+}
+
+abp_chain_solution solve_abp_chain(const abp_chain_parameters &parameters, double tail_mass) {
+    abp_chain_solution solution;
+    double total = 0;
+    for (const auto &delay : parameters.link_delay_ms) {
+        if (delay.first < 0 || delay.second < 0) {
+            solution.reason = "negative link delay or probability";
+            return solution;
+        }
+        total += delay.second;
+    }
+    if (total <= 0 || parameters.loss < 0 || parameters.loss >= 1) {
+        solution.reason = (total <= 0) ? "no link delay" : "the loss probability must be in [0, 1)";
+        return solution;
+    }
+
+    /** Round trip of an attempt: link delay + receiver preparation + link delay */
+    map<long long, double> round_trip;
+    for (const auto &packet : parameters.link_delay_ms) {
+        for (const auto &ack : parameters.link_delay_ms) {
+            round_trip[packet.first + parameters.receiver_preparation_ms + ack.first]
+                += (packet.second / total) * (ack.second / total);
+        }
+    }
+    long long cycle = parameters.timeout_ms + parameters.sender_preparation_ms;
+    if (round_trip.rbegin()->first >= cycle) {
+        solution.reason = "a round trip can last until the next attempt, which then shares the subnets";
+        return solution;
+    }
+
+    double rtt_mean = 0, rtt_square = 0;
+    for (const auto &rtt : round_trip) {
+        rtt_mean += rtt.first * rtt.second;
+        rtt_square += (double) rtt.first * rtt.first * rtt.second;
+    }
+    double s = (1 - parameters.loss) * (1 - parameters.loss);
+    double failures = (1 - s) / s;
+    solution.applicable = true;
+    solution.success = s;
+    solution.mean_transmissions = 1 + failures;
+    solution.mean_delay_ms = failures * cycle + rtt_mean;
+    solution.delay_std_ms = sqrt((double) cycle * cycle * (1 - s) / (s * s) + rtt_square - rtt_mean * rtt_mean);
+    solution.throughput_per_hour = 3600000.0 / (parameters.sender_preparation_ms + solution.mean_delay_ms);
+
+    /** P(K = k) = (1 - s)^k s, the delays of successive k don't overlap since RTT < cycle */
+    double remaining = 1;
+    for (long long k = 0; remaining > tail_mass && k < 100000; k++) {
+        double p = pow(1 - s, k) * s;
+        for (const auto &rtt : round_trip) {
+            solution.delay_pmf[k * cycle + rtt.first] += p * rtt.second;
+        }
+        remaining = pow(1 - s, k + 1);
+    }
+    solution.truncated = max(0.0, remaining);
+    return solution;
+}
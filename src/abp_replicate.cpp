@@ -0,0 +1,416 @@
+/** \brief Replications of the ABP scenario until the confidence intervals are tight enough
+ *
+ * A single run of the ABP simulator is one draw of its losses. ABP_REPLICATE runs
+ * replications of a scenario, each with its own replication seed (abp_parameters::seed),
+ * and stops as soon as the Student t confidence interval of the mean delay and of the
+ * goodput of every configuration has a half-width below the target precision, a fraction
+ * of the mean. It never stops before --min replications nor runs more than --max.
+ *
+ * With several --config, replication n of every configuration uses the same seed
+ * (common random numbers): the configurations see the same loss draws, so the difference
+ * between two configurations is measured on paired runs and its variance is much lower
+ * than the sum of their variances. The intervals of the differences to the first
+ * configuration then have to reach the precision too, relative to the mean of the first
+ * configuration. --independent gives every run its own seed instead, to compare.
+ *
+ * A configuration is a comma separated list of parameters of the senders and receivers,
+ * the same as the ones of an ABP_SERVER job and parsed by the same abp_set_parameter
+ * (abp_parameters.hpp): timeout=t,preparation=t,ack_preparation=t,
+ * ack_delay=t,ack_every=N,nak=1,overlap=1,queue=1,bags=in_order|queue|drop,link_trace=file,
+ * trace_offset=N,trace_reverse_offset=N,trace_stride=N,trace_loop=1. The acknowledgements
+ * sent by the receivers, the messages of the reverse link, the percentiles of the delays of
+ * the packets of all its replications and the requests of the control input
+ * (output_request_report: wait before their first transmission, packets per hour of the
+ * done ones, dropped ones) are reported with every configuration.
+ *
+ * Usage: ./bin/ABP_REPLICATE <control input> [horizon] [--config params]... [--precision 0.05]
+ *                            [--confidence 0.95] [--min 10] [--max 1000] [--seed 1]
+ *                            [--independent] [--output replications.csv]
+ *
+ * Output: one line per configuration and metric with its mean and interval, one line per
+ * difference with its interval and variance reduction ((s_a^2 + s_b^2) / s_d^2), and, with
+ * --output, the metrics of every run:
+ *      Replication,Seed,Config,Delay,Goodput,Acks,Wait,RequestGoodput,Dropped
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+#include <sys/stat.h>
+
+#include "../lib/DESTimes/include/NDTime.hpp"
+
+#include "../include/simulator_renaissance.hpp"
+#include "../include/abp_runner.hpp"
+
+using namespace std;
+
+using hclock=chrono::high_resolution_clock;
+using TIME = NDTime;
+
+/**
+ * Structure holding a configuration and the metrics of its replications
+ */
+struct replicated_config{
+    string label;
+    abp_parameters<TIME> parameters;
+    vector<double> delay;    /**< Mean delay of every replication in seconds */
+    vector<double> goodput;  /**< Goodput of every replication in packets per hour */
+    vector<double> acks;     /**< Acknowledgements sent by the receivers in every replication */
+    vector<double> packet_delays; /**< Delays of the delivered packets of all the replications */
+    vector<double> wait;     /**< Mean wait of the served requests of every replication in seconds */
+    vector<double> request_goodput; /**< Packets of the done requests per hour of every replication */
+    vector<double> dropped;  /**< Requests dropped in every replication */
+};
+
+/**
+ * Structure holding the confidence interval of a sample
+ */
+struct interval{
+    double mean = 0;
+    double variance = 0;
+    double half_width = 0;
+};
+
+/**
+ * @brief      Quantile of the standard normal distribution
+ * Bisection on erfc, precise to far below what the intervals need.
+ */
+static double normal_quantile(double p) {
+    double low = -10, high = 10;
+    for (int i = 0; i < 100; i++) {
+        double middle = (low + high) / 2;
+        if (0.5 * erfc(-middle / sqrt(2.0)) < p) {
+            low = middle;
+        }else {
+            high = middle;
+        }
+    }
+    return (low + high) / 2;
+}
+
+/**
+ * @brief      Quantile of the Student t distribution
+ * Cornish-Fisher expansion around the normal quantile, within 0.01 of the exact
+ * value from 4 degrees of freedom.
+ */
+static double student_quantile(double p, int dof) {
+    double z = normal_quantile(p);
+    double v = dof;
+    double z3 = z * z * z, z5 = z3 * z * z, z7 = z5 * z * z, z9 = z7 * z * z;
+    return z + (z3 + z) / (4 * v)
+             + (5 * z5 + 16 * z3 + 3 * z) / (96 * v * v)
+             + (3 * z7 + 19 * z5 + 17 * z3 - 15 * z) / (384 * v * v * v)
+             + (79 * z9 + 776 * z7 + 1482 * z5 - 1920 * z3 - 945 * z) / (92160 * v * v * v * v);
+}
+
+/**
+ * @brief      Confidence interval of the mean of a sample
+ */
+static interval confidence_interval(const vector<double> &sample, double confidence) {
+    interval result;
+    size_t n = sample.size();
+    if (n == 0) {
+        return result;
+    }
+    for (double x : sample) {
+        result.mean += x;
+    }
+    result.mean /= n;
+    if (n < 2) {
+        result.half_width = INFINITY;
+        return result;
+    }
+    for (double x : sample) {
+        result.variance += (x - result.mean) * (x - result.mean);
+    }
+    result.variance /= (n - 1);
+    result.half_width = student_quantile(1 - (1 - confidence) / 2, n - 1) * sqrt(result.variance / n);
+    return result;
+}
+
+/**
+ * @brief      Differences of two paired samples
+ */
+static vector<double> differences(const vector<double> &a, const vector<double> &b) {
+    vector<double> result;
+    for (size_t i = 0; i < a.size() && i < b.size(); i++) {
+        result.push_back(b[i] - a[i]);
+    }
+    return result;
+}
+
+/**
+ * @brief      Sets a parameter of a configuration
+ * @return     empty if the parameter is valid, otherwise the error message
+ */
+static string set_parameter(const string &parameter, abp_parameters<TIME> &parameters) {
+    size_t equal = parameter.find('=');
+    string key = parameter.substr(0, equal);
+    string value = (equal == string::npos) ? "" : parameter.substr(equal + 1);
+    if (key == "seed") {
+        return "the seeds of the replications are set by --seed";
+    }
+    return abp_set_parameter(key, value, parameters);
+}
+
+/**
+ * @brief      Seconds of a HH:MM:SS:mmm time of the delivery report
+ */
+static double report_time_secs(const string &time) {
+    vector<string> fields = split(time, ':');
+    if (fields.size() != 4) {
+        return NAN;
+    }
+    return (stoll(fields[0]) * 3600 + stoll(fields[1]) * 60 + stoll(fields[2])) + stoll(fields[3]) / 1000.0;
+}
+
+/**
+ * @brief      Nearest rank percentile of a sorted sample
+ */
+static double percentile(const vector<double> &sorted, double p) {
+    if (sorted.empty()) {
+        return NAN;
+    }
+    size_t rank = (size_t) ceil(p * sorted.size());
+    return sorted[(rank > 0) ? rank - 1 : 0];
+}
+
+/**
+ * @brief      Reads the summary rows of a report
+ */
+static map<string, string> report_summary(const string &report) {
+    map<string, string> summary;
+    istringstream report_stream(report);
+    string line;
+    while (getline(report_stream, line)) {
+        vector<string> fields = split(line, ',');
+        if (fields.size() == 2) {
+            summary[fields[0]] = fields[1];
+        }
+    }
+    return summary;
+}
+
+/**
+ * @brief      Runs one replication of a configuration and reads its metrics
+ * The metrics of the requests are added to the back of the samples of the configuration.
+ * @return     false if no packet was delivered, the mean delay is undefined then
+ */
+static bool run_replication(abp_runner<TIME> &runner, const string &input, const string &horizon,
+                            const abp_parameters<TIME> &parameters, double &delay, double &goodput, double &acks,
+                            replicated_config &config) {
+    ostringstream trace;
+    runner.run(input.c_str(), TIME(horizon.c_str()), &trace, parameters);
+    istringstream trace_stream(trace.str());
+    ostringstream csv;
+    output_file_evolution(trace_stream, csv);
+    istringstream csv_stream(csv.str());
+    ostringstream report;
+    output_delivery_report(csv_stream, report, true);
+
+    map<string, string> summary = report_summary(report.str());
+    istringstream report_stream(report.str());
+    string line;
+    while (getline(report_stream, line)) {
+        vector<string> fields = split(line, ',');
+        if (fields.size() == 7 && fields[0] != "Component" && !fields[6].empty()) {
+            config.packet_delays.push_back(report_time_secs(fields[6]));
+        }
+    }
+
+    /** The requests of the same csv, with the acceptance rule of the configuration */
+    csv_stream.clear();
+    csv_stream.seekg(0);
+    ostringstream request_report;
+    output_request_report(csv_stream, request_report, parameters.queue_requests, false, parameters.bags);
+    map<string, string> requests = report_summary(request_report.str());
+    config.wait.push_back(requests.count("wait_avg") ? report_time_secs(requests["wait_avg"]) : 0);
+    config.request_goodput.push_back(atof(requests["packets_per_hour"].c_str()));
+    config.dropped.push_back(atof(requests["dropped"].c_str()));
+
+    goodput = atof(summary["goodput"].c_str());
+    acks = atof(summary["acks"].c_str());
+    delay = summary.count("avg") ? report_time_secs(summary["avg"]) : NAN;
+    return !std::isnan(delay);
+}
+
+/**\brief  main function
+ *
+ * @param argc Integer argument - These are counting the command line arguments
+ * @param argv Argument vector - control input, horizon and options
+ */
+int main(int argc, char ** argv){
+
+    vector<string> args;
+    vector<replicated_config> configs;
+    double precision = 0.05;
+    double confidence = 0.95;
+    int min_replications = 10;
+    int max_replications = 1000;
+    unsigned int base_seed = 1;
+    bool independent = false;
+    string output_file;
+    for (int i = 1; i < argc; i++) {
+        string option = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (option == "--config" && has_value) {
+            replicated_config config;
+            config.label = argv[++i];
+            for (const string &parameter : split(config.label, ',')) {
+                string error = set_parameter(parameter, config.parameters);
+                if (!error.empty()) {
+                    cout << error << endl;
+                    return 1;
+                }
+            }
+            string inconsistent = abp_check_parameters(config.parameters);
+            if (!inconsistent.empty()) {
+                cout << inconsistent << endl;
+                return 1;
+            }
+            configs.push_back(config);
+        }else if (option == "--precision" && has_value) {
+            precision = atof(argv[++i]);
+        }else if (option == "--confidence" && has_value) {
+            confidence = atof(argv[++i]);
+        }else if (option == "--min" && has_value) {
+            min_replications = atoi(argv[++i]);
+        }else if (option == "--max" && has_value) {
+            max_replications = atoi(argv[++i]);
+        }else if (option == "--seed" && has_value) {
+            base_seed = (unsigned int) strtoul(argv[++i], nullptr, 10);
+        }else if (option == "--output" && has_value) {
+            output_file = argv[++i];
+        }else if (option == "--independent") {
+            independent = true;
+        }else {
+            args.push_back(option);
+        }
+    }
+    if (args.empty() || precision <= 0 || confidence <= 0 || confidence >= 1 || base_seed == 0) {
+        cout << "you are using this program with wrong parameters. The program should be invoked as follow:";
+        cout << argv[0] << " control input [horizon] [--config params]... [--precision 0.05] [--confidence 0.95]"
+             << " [--min 10] [--max 1000] [--seed 1] [--independent] [--output file]" << endl;
+        return 1;
+    }
+    string input = args[0];
+    string horizon = (args.size() > 1) ? args[1] : "04:00:00:000";
+    struct stat stat_buff;
+    if (stat(input.c_str(), &stat_buff) < 0) {
+        cout << input << " doesn't exist" << endl;
+        return 1;
+    }
+    if (configs.empty()) {
+        configs.push_back(replicated_config());
+        configs.back().label = "default";
+    }
+    /** Below 2 replications there is no variance, below 4 the t quantile is rough */
+    min_replications = max(min_replications, 4);
+    max_replications = max(max_replications, min_replications);
+
+    ofstream output;
+    if (!output_file.empty()) {
+        output.open(output_file, ofstream::out | ofstream::trunc);
+        output << "Replication,Seed,Config,Delay,Goodput,Acks,Wait,RequestGoodput,Dropped" << endl;
+    }
+
+    auto start = hclock::now();
+    abp_runner<TIME> runner;
+    int replications = 0;
+    bool converged = false;
+    while (replications < max_replications && !converged) {
+        replications++;
+        for (size_t c = 0; c < configs.size(); c++) {
+            /** Common random numbers: the configurations of a replication share its seed */
+            abp_parameters<TIME> parameters = configs[c].parameters;
+            parameters.seed = independent ? base_seed + (replications - 1) * configs.size() + c
+                                          : base_seed + replications - 1;
+            double delay, goodput, acks;
+            if (!run_replication(runner, input, horizon, parameters, delay, goodput, acks, configs[c])) {
+                cout << "replication " << replications << " of " << configs[c].label
+                     << " delivered no packet, its mean delay is undefined" << endl;
+                return 1;
+            }
+            configs[c].delay.push_back(delay);
+            configs[c].goodput.push_back(goodput);
+            configs[c].acks.push_back(acks);
+            if (output.is_open()) {
+                output << replications << "," << parameters.seed << ",\"" << configs[c].label << "\","
+                       << delay << "," << goodput << "," << acks << "," << configs[c].wait.back() << ","
+                       << configs[c].request_goodput.back() << "," << configs[c].dropped.back() << endl;
+            }
+        }
+        if (replications < min_replications) {
+            continue;
+        }
+        converged = true;
+        for (size_t c = 0; c < configs.size() && converged; c++) {
+            interval delay = confidence_interval(configs[c].delay, confidence);
+            interval goodput = confidence_interval(configs[c].goodput, confidence);
+            converged = delay.half_width <= precision * fabs(delay.mean)
+                        && goodput.half_width <= precision * fabs(goodput.mean);
+            if (c > 0 && converged) {
+                /** The differences are tight enough relative to the first configuration */
+                interval base_delay = confidence_interval(configs[0].delay, confidence);
+                interval base_goodput = confidence_interval(configs[0].goodput, confidence);
+                converged = confidence_interval(differences(configs[0].delay, configs[c].delay), confidence).half_width
+                                <= precision * fabs(base_delay.mean)
+                            && confidence_interval(differences(configs[0].goodput, configs[c].goodput), confidence).half_width
+                                <= precision * fabs(base_goodput.mean);
+            }
+        }
+    }
+    double secs = chrono::duration_cast<chrono::duration<double, ratio<1>>>(hclock::now() - start).count();
+
+    cout << (converged ? "converged" : "not converged") << " after " << replications << " replications of "
+         << configs.size() << " configurations (" << (independent ? "independent seeds" : "common random numbers")
+         << ", " << confidence * 100 << "% intervals, precision " << precision * 100 << "%) in " << secs << "sec"
+         << endl;
+    for (replicated_config &config : configs) {
+        interval delay = confidence_interval(config.delay, confidence);
+        interval goodput = confidence_interval(config.goodput, confidence);
+        interval acks = confidence_interval(config.acks, confidence);
+        cout << config.label << ": delay " << delay.mean << " +- " << delay.half_width << " sec, goodput "
+             << goodput.mean << " +- " << goodput.half_width << " packets/hour, acks " << acks.mean << " +- "
+             << acks.half_width << " per run" << endl;
+        sort(config.packet_delays.begin(), config.packet_delays.end());
+        cout << config.label << ": packet delay p50 " << percentile(config.packet_delays, 0.5) << " sec, p95 "
+             << percentile(config.packet_delays, 0.95) << " sec, p99 " << percentile(config.packet_delays, 0.99)
+             << " sec of " << config.packet_delays.size() << " packets" << endl;
+        interval wait = confidence_interval(config.wait, confidence);
+        interval request_goodput = confidence_interval(config.request_goodput, confidence);
+        interval dropped = confidence_interval(config.dropped, confidence);
+        cout << config.label << ": request wait " << wait.mean << " +- " << wait.half_width << " sec, "
+             << request_goodput.mean << " +- " << request_goodput.half_width << " packets/hour of done requests, "
+             << dropped.mean << " +- " << dropped.half_width << " dropped per run" << endl;
+    }
+    for (size_t c = 1; c < configs.size(); c++) {
+        const char *metric_names[2] = {"delay", "goodput"};
+        const vector<double> *base_samples[2] = {&configs[0].delay, &configs[0].goodput};
+        const vector<double> *samples[2] = {&configs[c].delay, &configs[c].goodput};
+        for (int m = 0; m < 2; m++) {
+            interval difference = confidence_interval(differences(*base_samples[m], *samples[m]), confidence);
+            double unpaired = confidence_interval(*base_samples[m], confidence).variance
+                              + confidence_interval(*samples[m], confidence).variance;
+            bool significant = fabs(difference.mean) > difference.half_width;
+            cout << configs[c].label << " - " << configs[0].label << ": " << metric_names[m] << " "
+                 << difference.mean << " +- " << difference.half_width
+                 << (significant ? " (significant)" : " (not significant)") << ", variance reduction "
+                 << (difference.variance > 0 ? unpaired / difference.variance : INFINITY) << endl;
+        }
+    }
+    return converged ? 0 : 1;
+}
@@ -0,0 +1,454 @@
+/** \brief Long running simulation service over a Unix domain socket
+ *
+ * Running a scenario with ./bin/ABP pays for the process startup, the model
+ * construction by the cadmium runner and the trace, csv and statistics files.
+ * ABP_SERVER keeps a pool of worker threads running and accepts scenario jobs
+ * on a Unix domain socket. Every worker keeps the topologies it has built
+ * (abp_runner.hpp, one per number of pairs) and re-arms them for its next jobs.
+ * A job runs the ABP simulator with an in-memory trace, converts it with the stream versions
+ * of output_file_evolution and output_delivery_report and streams the statistics
+ * back. Nothing is written to disk.
+ *
+ * The protocol is line based. A client may send any number of requests on one
+ * connection, the jobs run concurrently and their answers come back as they are
+ * done, so they may come back in another order than the requests:
+ *      RUN <id> <control input> <horizon HH:MM:SS:mmm> [pairs=N] [timeline=HH:MM:SS:mmm] [packets=1]
+ *          [timeout=t] [preparation=t] [ack_preparation=t] [ack_delay=t] [ack_every=N] [nak=1] [overlap=1] [seed=N]
+ *          [queue=1] [requests=1] [bags=in_order|queue|drop]
+ *          [link_trace=file] [trace_offset=N] [trace_reverse_offset=N] [trace_stride=N] [trace_loop=1]
+ *          answers
+ *          BEGIN <id>
+ *          <summary rows of the delivery report: packets,N  delivered,N ... avg,HH:MM:SS:mmm>
+ *          <bag_drops,N if bags=drop or packets of bags were dropped, see abp_runner::bag_drops>
+ *          <timeline csv if timeline= is given, rows of every packet if packets=1>
+ *          <summary rows of the request report if requests=1: requests,N  served,N ... packets_per_hour,N>
+ *          END <id> <events> <secs>
+ *          or
+ *          ERROR <id> <message>
+ *      QUIT       closes the connection once its jobs are answered
+ *      SHUTDOWN   stops accepting connections, answers the jobs already received and exits
+ * pairs=N runs the pairs 1..N of make_abp_pairs_flat instead of the single simulator.
+ * The other parameters are the ones of abp_set_parameter (abp_parameters.hpp), the flags take 0 or 1.
+ * timeout and preparation set the timeout and preparation time of the senders,
+ * ack_preparation the preparation time of the receivers, ack_delay and ack_every
+ * how long and for how many packets they hold their acknowledgements (abp_parameters).
+ * nak=1 turns the losses into damaged messages answered by negative acknowledgements.
+ * overlap=1 has the senders prepare their next packet while waiting for the ack.
+ * queue=1 has the senders queue the requests of the control input arriving during a
+ * transfer instead of dropping them, requests=1 adds the summary of their waits.
+ * bags sets how the models take several messages arriving at the same time (bag_policy.hpp).
+ * link_trace replays a recorded link trace on the subnets (link_trace.hpp), subnet1 from
+ * trace_offset and subnet2 from trace_reverse_offset, pair k > 1 trace_stride further per
+ * pair, and starts it again at its end with trace_loop=1. A worker maps a trace once.
+ * seed=N draws the losses from the streams of replication seed N.
+ *
+ * Usage: ./bin/ABP_SERVER [socket path] [workers]
+ * test/src/client/client.cpp is a stand-in client.
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../lib/DESTimes/include/NDTime.hpp"
+
+#include "../include/simulator_renaissance.hpp"
+#include "../include/abp_runner.hpp"
+#include "../include/trace_reader.hpp"
+
+using namespace std;
+
+using hclock=chrono::high_resolution_clock;
+using TIME = NDTime;
+
+/**Default path of the socket*/
+char server_socket_file[] = "/tmp/abp_server.sock";
+
+/**
+ * @brief      Connection of a client
+ * The socket is closed when the reader of the connection and all its jobs are done
+ * with it. Answers are written whole under the lock, so they don't interleave.
+ */
+struct client_connection{
+    int fd;
+    mutex write_mutex;
+
+    client_connection(int i_fd) : fd(i_fd) {}
+
+    ~client_connection() {
+        close(fd);
+    }
+
+    /** Writes an answer, false if the client is gone */
+    bool send_answer(const string &answer) {
+        lock_guard<mutex> lock(write_mutex);
+        size_t sent = 0;
+        while (sent < answer.size()) {
+            ssize_t n = ::send(fd, answer.data() + sent, answer.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                return false;
+            }
+            sent += n;
+        }
+        return true;
+    }
+};
+
+/**
+ * Structure holding a scenario job
+ */
+struct scenario_job{
+    string id;
+    string input;
+    string horizon;
+    int pairs = 1;
+    long long bucket_ms = 0;   /**< Width of the timeline buckets, 0 for no timeline */
+    bool packet_rows = false;
+    bool request_summary = false;
+    abp_parameters<TIME> parameters;
+    shared_ptr<client_connection> client;
+};
+
+/**
+ * @brief      Runs a job on the runner of its number of pairs and returns its answer
+ */
+static string run_job(const scenario_job &job, map<int, abp_runner<TIME>> &runners) {
+    auto start = hclock::now();
+    ostringstream trace;
+    abp_runner<TIME> &runner = runners.emplace(job.pairs, job.pairs).first->second;
+    runner.run(job.input.c_str(), TIME(job.horizon.c_str()), &trace, job.parameters);
+
+    istringstream trace_stream(trace.str());
+    ostringstream csv;
+    trace_timeline timeline(job.bucket_ms);
+    output_file_evolution(trace_stream, csv, job.bucket_ms > 0 ? &timeline : nullptr);
+    string csv_string = csv.str();
+    long events = 0;
+    for (char c : csv_string) {
+        events += (c == '\n');
+    }
+
+    ostringstream answer;
+    answer << "BEGIN " << job.id << "\n";
+    istringstream csv_stream(csv_string);
+    output_delivery_report(csv_stream, answer, job.packet_rows);
+    long bag_drops = runner.bag_drops();
+    if (job.parameters.bags == bag_policy::drop || bag_drops > 0) {
+        answer << "bag_drops," << bag_drops << "\n";
+    }
+    if (job.bucket_ms > 0) {
+        timeline.write(answer);
+    }
+    if (job.request_summary) {
+        istringstream request_stream(csv_string);
+        output_request_report(request_stream, answer, job.parameters.queue_requests, false, job.parameters.bags);
+    }
+    double secs = chrono::duration_cast<chrono::duration<double, ratio<1>>>(hclock::now() - start).count();
+    answer << "END " << job.id << " " << max(0L, events - 1) << " " << secs << "\n";
+    return answer.str();
+}
+
+/**
+ * @brief      Pool of worker threads running the jobs in the order they are received
+ */
+class job_pool{
+    public:
+        job_pool(int workers) {
+            for (int i = 0; i < workers; i++) {
+                threads.emplace_back([this]() { work(); });
+            }
+        }
+
+        /** Queues a job, false once the pool is stopping */
+        bool submit(scenario_job job) {
+            {
+                lock_guard<mutex> lock(queue_mutex);
+                if (stopping) {
+                    return false;
+                }
+                jobs.push_back(move(job));
+            }
+            queue_ready.notify_one();
+            return true;
+        }
+
+        /** Runs the queued jobs and joins the workers */
+        void stop() {
+            {
+                lock_guard<mutex> lock(queue_mutex);
+                stopping = true;
+            }
+            queue_ready.notify_all();
+            for (thread &t : threads) {
+                t.join();
+            }
+            threads.clear();
+        }
+
+        long long completed() const {
+            return done.load();
+        }
+
+    private:
+        void work() {
+            map<int, abp_runner<TIME>> runners;
+            while (true) {
+                scenario_job job;
+                {
+                    unique_lock<mutex> lock(queue_mutex);
+                    queue_ready.wait(lock, [this]() { return stopping || !jobs.empty(); });
+                    if (jobs.empty()) {
+                        return;
+                    }
+                    job = move(jobs.front());
+                    jobs.pop_front();
+                }
+                string answer;
+                try {
+                    answer = run_job(job, runners);
+                }catch (const exception &e) {
+                    answer = "ERROR " + job.id + " " + e.what() + "\n";
+                }
+                job.client->send_answer(answer);
+                ++done;
+            }
+        }
+
+        vector<thread> threads;
+        deque<scenario_job> jobs;
+        mutex queue_mutex;
+        condition_variable queue_ready;
+        bool stopping = false;
+        atomic<long long> done{0};
+};
+
+/**
+ * @brief      Converts a time of a request (HH:MM:SS:mmm) to milliseconds
+ * @return     Milliseconds, -1 if the value is not a time
+ */
+static long long parse_job_time(const string &value) {
+    if (split(value, ':').size() != 4) {
+        return -1;
+    }
+    return parse_time_ms(value);
+}
+
+/**
+ * @brief      Parses a RUN request
+ * @return     empty if the job is valid, otherwise the error message
+ */
+static string parse_job(const vector<string> &words, scenario_job &job) {
+    if (words.size() < 4) {
+        return "usage: RUN <id> <control input> <horizon> [pairs=N] [timeline=t] [packets=1] [timeout=t] ...";
+    }
+    job.id = words[1];
+    job.input = words[2];
+    job.horizon = words[3];
+    struct stat stat_buff;
+    if (stat(job.input.c_str(), &stat_buff) < 0) {
+        return job.input + " doesn't exist";
+    }
+    if (parse_job_time(job.horizon) < 0) {
+        return "invalid horizon " + job.horizon;
+    }
+    for (size_t i = 4; i < words.size(); i++) {
+        size_t equal = words[i].find('=');
+        string key = words[i].substr(0, equal);
+        string value = (equal == string::npos) ? "" : words[i].substr(equal + 1);
+        if (key == "pairs") {
+            job.pairs = atoi(value.c_str());
+            if (job.pairs < 1) {
+                return "invalid pairs " + value;
+            }
+        }else if (key == "timeline") {
+            job.bucket_ms = parse_job_time(value);
+            if (job.bucket_ms <= 0) {
+                return "invalid timeline " + value;
+            }
+        }else if (key == "packets" || key == "requests") {
+            if (value != "0" && value != "1") {
+                return "invalid " + key + " " + value;
+            }
+            (key == "packets" ? job.packet_rows : job.request_summary) = (value == "1");
+        }else {
+            string error = abp_set_parameter(key, value, job.parameters);
+            if (!error.empty()) {
+                return error;
+            }
+        }
+    }
+    return abp_check_parameters(job.parameters);
+}
+
+/** Listening socket, closed by SHUTDOWN to stop the accept loop */
+static atomic<int> listen_fd(-1);
+static atomic<bool> shutting_down(false);
+
+/**
+ * @brief      Reads the requests of a connection and queues its jobs
+ */
+static void serve_connection(shared_ptr<client_connection> client, job_pool &pool) {
+    string pending;
+    char buffer[4096];
+    while (true) {
+        ssize_t n = read(client->fd, buffer, sizeof(buffer));
+        if (n <= 0) {
+            return;
+        }
+        pending.append(buffer, n);
+        size_t end;
+        while ((end = pending.find('\n')) != string::npos) {
+            string line = pending.substr(0, end);
+            pending.erase(0, end + 1);
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            vector<string> words;
+            for (const string &word : split(line, ' ')) {
+                if (!word.empty()) {
+                    words.push_back(word);
+                }
+            }
+            if (words.empty()) {
+                continue;
+            }
+            if (words[0] == "QUIT") {
+                return;
+            }
+            if (words[0] == "SHUTDOWN") {
+                shutting_down = true;
+                ::shutdown(listen_fd.load(), SHUT_RDWR);
+                return;
+            }
+            if (words[0] != "RUN") {
+                client->send_answer("ERROR - unknown request " + words[0] + "\n");
+                continue;
+            }
+            /** A connection runs on its own thread, a request it can't parse must not end the server */
+            scenario_job job;
+            string error;
+            try {
+                error = parse_job(words, job);
+            }catch (const exception &e) {
+                error = e.what();
+            }
+            if (!error.empty()) {
+                client->send_answer("ERROR " + (job.id.empty() ? "-" : job.id) + " " + error + "\n");
+                continue;
+            }
+            job.client = client;
+            if (!pool.submit(move(job))) {
+                client->send_answer("ERROR " + words[1] + " server is shutting down\n");
+            }
+        }
+    }
+}
+
+/**
+ * Reader thread of a connection, joined once done so a long running server doesn't keep them
+ */
+struct connection_reader{
+    thread reader;
+    shared_ptr<atomic<bool>> done;
+    weak_ptr<client_connection> client;
+};
+
+/**\brief  main function
+ *
+ * @param argc Integer argument - These are counting the command line arguments
+ * @param argv Argument vector - socket path and number of workers
+ */
+int main(int argc, char ** argv){
+
+    string socket_path = (argc > 1) ? argv[1] : server_socket_file;
+    int workers = (argc > 2) ? atoi(argv[2]) : (int) thread::hardware_concurrency();
+    if (workers < 1) {
+        workers = 1;
+    }
+
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        cout << "socket path too long: " << socket_path << endl;
+        return 1;
+    }
+    strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socket_path.c_str());
+    if (fd < 0 || ::bind(fd, (sockaddr*) &address, sizeof(address)) < 0 || listen(fd, 64) < 0) {
+        cout << "can't listen on " << socket_path << ": " << strerror(errno) << endl;
+        return 1;
+    }
+    listen_fd = fd;
+    signal(SIGPIPE, SIG_IGN);
+
+    job_pool pool(workers);
+    vector<connection_reader> readers;
+    cout << "ABP_SERVER listening on " << socket_path << " with " << workers << " workers" << endl;
+
+    while (!shutting_down) {
+        int client_fd = accept(fd, nullptr, nullptr);
+        if (client_fd < 0) {
+            if (shutting_down || errno != EINTR) {
+                break;
+            }
+            continue;
+        }
+        for (size_t i = 0; i < readers.size(); ) {
+            if (*readers[i].done) {
+                readers[i].reader.join();
+                readers[i] = move(readers.back());
+                readers.pop_back();
+            }else {
+                i++;
+            }
+        }
+        shared_ptr<client_connection> client = make_shared<client_connection>(client_fd);
+        connection_reader reader;
+        reader.done = make_shared<atomic<bool>>(false);
+        reader.client = client;
+        shared_ptr<atomic<bool>> done = reader.done;
+        reader.reader = thread([client, done, &pool]() {
+            serve_connection(client, pool);
+            *done = true;
+        });
+        readers.push_back(move(reader));
+    }
+
+    /** Stops reading the open connections, their queued jobs are still answered */
+    for (connection_reader &reader : readers) {
+        if (shared_ptr<client_connection> open = reader.client.lock()) {
+            ::shutdown(open->fd, SHUT_RD);
+        }
+    }
+    for (connection_reader &reader : readers) {
+        reader.reader.join();
+    }
+    pool.stop();
+    close(fd);
+    unlink(socket_path.c_str());
+    cout << "ABP_SERVER stopped after " << pool.completed() << " jobs" << endl;
+    return 0;
+}
@@ -0,0 +1,282 @@
+/** \brief Rare event estimation of the ABP simulator by importance splitting (RESTART)
+ *
+ * With 95% of the packets delivered by each subnet, a packet whose delay is several
+ * timeouts long needs several losses in a row: plain Monte Carlo sees few of them in
+ * many runs. ABP_SPLITTING estimates the probability that the delay of a packet
+ * (first send to ack, as in the delivery report) exceeds a threshold with RESTART:
+ *      - the importance of the state of a run is the number of retransmissions of the
+ *        packet being sent (Sender::state.transmissions - 1, 0 once it is acked)
+ *      - when a run crosses a level L_i upwards, its state is saved (flat_kernel::save)
+ *        and R_i - 1 retrials are run from it, each with new loss streams in its
+ *        subnets, before the run goes on. A retrial ends when it goes back below its
+ *        level, i.e. when its packet is acked, or at the horizon
+ *      - a packet acked in the region between levels L_i and L_i+1 is counted with the
+ *        weight 1 / (R_1 ... R_i)
+ * The weighted counts are unbiased estimates of the numbers of packets and of late
+ * packets of a run; their ratio over independent replications estimates the probability.
+ * --plain runs the same replications without splitting, to compare.
+ *
+ * Usage: ./bin/ABP_SPLITTING <control input> [horizon] [--replications 100] [--timeout t]
+ *                            [--factor 5 | --threshold t] [--levels 1,2,3] [--splits 10[,10,...]]
+ *                            [--seed 1] [--plain]
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+#include <sys/stat.h>
+
+#include "../lib/DESTimes/include/NDTime.hpp"
+
+#include "../include/simulator_renaissance.hpp"
+#include "../include/abp_topology.hpp"
+#include "../include/flat_kernel.hpp"
+
+using namespace std;
+
+using hclock=chrono::high_resolution_clock;
+using TIME = NDTime;
+
+/**
+ * Structure holding the parameters of the splitting
+ */
+struct splitting_setup{
+    vector<int> levels;       /**< Retransmissions of the levels, increasing */
+    vector<int> splits;       /**< Trajectories of a run crossing each level, the run included */
+    vector<double> weights;   /**< Weight of a packet acked in each region, 1 below the first level */
+    TIME end;
+    TIME threshold;           /**< A packet is late when its delay exceeds it */
+};
+
+/**
+ * Structure holding what a trajectory knows of its current packet, saved with the kernel
+ */
+struct packet_observer{
+    TIME first_send;
+    int transmissions = 0;
+    bool ack = false;
+    int region = 0;           /**< Levels at or below the retransmissions of the packet */
+};
+
+/**
+ * Structure holding the weighted counts of a replication
+ */
+struct splitting_counts{
+    double packets = 0;
+    double late = 0;
+    long long trajectories = 0;
+    long long steps = 0;
+};
+
+/**
+ * @brief      Region of an importance value: number of levels it has reached
+ */
+static int level_region(const splitting_setup &setup, int importance) {
+    int region = 0;
+    while (region < (int) setup.levels.size() && importance >= setup.levels[region]) {
+        region++;
+    }
+    return region;
+}
+
+/**
+ * @brief      Gives new loss streams to the subnets of a retrial
+ * The loss draws are independent, so new streams from a saved state give another
+ * future with the law of the original one.
+ */
+static void reseed_subnets(flat_kernel<TIME> &kernel, unsigned int seed, int stream) {
+    kernel.template model<Subnet>("subnet1").state.loss_stream.seed(abp_replication_seed(seed, stream, 0));
+    kernel.template model<Subnet>("subnet2").state.loss_stream.seed(abp_replication_seed(seed, stream, 1));
+}
+
+/**
+ * @brief      Runs a trajectory until the horizon or until it leaves the region it was born in
+ *
+ * @param      kernel    kernel in the state the trajectory starts from
+ * @param[in]  setup     parameters of the splitting
+ * @param[in]  observer  current packet of the trajectory
+ * @param[in]  born      region of the trajectory, 0 for the main run of a replication
+ * @param[in]  seed      seed of the replication
+ * @param      stream    last loss stream given to a retrial
+ * @param      counts    weighted counts of the replication
+ */
+static void run_trajectory(flat_kernel<TIME> &kernel, const splitting_setup &setup, packet_observer observer,
+                           int born, unsigned int seed, int &stream, splitting_counts &counts) {
+    counts.trajectories++;
+    Sender<TIME> &sender = kernel.template model<Sender>("sender1");
+    while (kernel.next() < setup.end) {
+        TIME t = kernel.run_step();
+        counts.steps++;
+        if (observer.transmissions == 0 && sender.state.transmissions > 0) {
+            observer.first_send = t;
+        }
+        if (sender.state.ack && !observer.ack) {
+            /** The packet is acked in the region the trajectory was in */
+            counts.packets += setup.weights[observer.region];
+            if (setup.threshold < t - observer.first_send) {
+                counts.late += setup.weights[observer.region];
+            }
+        }
+        observer.ack = sender.state.ack;
+        observer.transmissions = sender.state.transmissions;
+        int region = level_region(setup, observer.ack ? 0 : max(0, observer.transmissions - 1));
+        if (region < born) {
+            return;
+        }
+        while (observer.region < region) {
+            observer.region++;
+            flat_kernel<TIME>::snapshot saved = kernel.save();
+            for (int r = 1; r < setup.splits[observer.region - 1]; r++) {
+                kernel.restore(saved);
+                reseed_subnets(kernel, seed, ++stream);
+                run_trajectory(kernel, setup, observer, observer.region, seed, stream, counts);
+            }
+            kernel.restore(saved);
+        }
+        observer.region = region;
+    }
+}
+
+/**
+ * @brief      Integers of a comma separated list
+ */
+static vector<int> int_list(const string &list) {
+    vector<int> values;
+    for (const string &value : split(list, ',')) {
+        if (!value.empty()) {
+            values.push_back(atoi(value.c_str()));
+        }
+    }
+    return values;
+}
+
+/**\brief  main function
+ *
+ * @param argc Integer argument - These are counting the command line arguments
+ * @param argv Argument vector - control input, horizon and options
+ */
+int main(int argc, char ** argv){
+
+    vector<string> args;
+    int replications = 100;
+    string timeout = "00:00:20:000";
+    double factor = 5;
+    string threshold;
+    string levels = "1,2,3";
+    string splits = "10";
+    unsigned int base_seed = 1;
+    bool plain = false;
+    for (int i = 1; i < argc; i++) {
+        string option = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (option == "--replications" && has_value) {
+            replications = atoi(argv[++i]);
+        }else if (option == "--timeout" && has_value) {
+            timeout = argv[++i];
+        }else if (option == "--factor" && has_value) {
+            factor = atof(argv[++i]);
+        }else if (option == "--threshold" && has_value) {
+            threshold = argv[++i];
+        }else if (option == "--levels" && has_value) {
+            levels = argv[++i];
+        }else if (option == "--splits" && has_value) {
+            splits = argv[++i];
+        }else if (option == "--seed" && has_value) {
+            base_seed = (unsigned int) strtoul(argv[++i], nullptr, 10);
+        }else if (option == "--plain") {
+            plain = true;
+        }else {
+            args.push_back(option);
+        }
+    }
+    splitting_setup setup;
+    setup.levels = plain ? vector<int>() : int_list(levels);
+    vector<int> split_values = int_list(splits);
+    bool valid = !args.empty() && replications > 1 && split(timeout, ':').size() == 4
+                 && (threshold.empty() || split(threshold, ':').size() == 4) && !split_values.empty();
+    for (size_t i = 0; i < setup.levels.size() && valid; i++) {
+        valid = setup.levels[i] > 0 && (i == 0 || setup.levels[i] > setup.levels[i - 1]);
+        setup.splits.push_back(split_values[min(i, split_values.size() - 1)]);
+        valid = valid && setup.splits.back() > 0;
+    }
+    if (!valid) {
+        cout << "you are using this program with wrong parameters. The program should be invoked as follow:";
+        cout << argv[0] << " control input [horizon] [--replications 100] [--timeout t] [--factor 5 | --threshold t]"
+             << " [--levels 1,2,3] [--splits 10[,10,...]] [--seed 1] [--plain]" << endl;
+        return 1;
+    }
+    string input = args[0];
+    struct stat stat_buff;
+    if (stat(input.c_str(), &stat_buff) < 0) {
+        cout << input << " doesn't exist" << endl;
+        return 1;
+    }
+    setup.end = TIME((args.size() > 1 ? args[1] : string("04:00:00:000")).c_str());
+    setup.weights.push_back(1);
+    for (int r : setup.splits) {
+        setup.weights.push_back(setup.weights.back() / r);
+    }
+    long long threshold_ms;
+    if (threshold.empty()) {
+        vector<string> t = split(timeout, ':');
+        long long timeout_ms = ((stoll(t[0]) * 60 + stoll(t[1])) * 60 + stoll(t[2])) * 1000 + stoll(t[3]);
+        threshold_ms = llround(timeout_ms * factor);
+    }else {
+        vector<string> t = split(threshold, ':');
+        threshold_ms = ((stoll(t[0]) * 60 + stoll(t[1])) * 60 + stoll(t[2])) * 1000 + stoll(t[3]);
+    }
+    setup.threshold = TIME({(int) (threshold_ms / 3600000), (int) (threshold_ms / 60000 % 60),
+                            (int) (threshold_ms / 1000 % 60), (int) (threshold_ms % 1000)});
+
+    auto start = hclock::now();
+    flat_kernel<TIME> kernel;
+    make_abp_flat(kernel, input.c_str());
+    vector<splitting_counts> runs(replications);
+    for (int r = 0; r < replications; r++) {
+        unsigned int seed = base_seed + r;
+        reset_abp_flat(kernel, input.c_str());
+        kernel.template model<Sender>("sender1").timeout = TIME(timeout.c_str());
+        reseed_subnets(kernel, seed, 0);
+        kernel.reset();
+        int stream = 0;
+        run_trajectory(kernel, setup, packet_observer(), 0, seed, stream, runs[r]);
+    }
+    double secs = chrono::duration_cast<chrono::duration<double, ratio<1>>>(hclock::now() - start).count();
+
+    /** Ratio estimator of late / packets over the replications, its variance by the delta method */
+    double packets = 0, late = 0;
+    long long trajectories = 0, steps = 0;
+    for (const splitting_counts &run : runs) {
+        packets += run.packets;
+        late += run.late;
+        trajectories += run.trajectories;
+        steps += run.steps;
+    }
+    double probability = (packets > 0) ? late / packets : 0;
+    double variance = 0;
+    for (const splitting_counts &run : runs) {
+        variance += pow(run.late - probability * run.packets, 2);
+    }
+    variance /= (replications - 1);
+    double mean_packets = packets / replications;
+    double std_error = (mean_packets > 0) ? sqrt(variance / replications) / mean_packets : 0;
+    double relative_error = (probability > 0) ? std_error / probability : INFINITY;
+
+    cout << (plain ? "plain Monte Carlo" : "RESTART levels " + levels + " splits " + splits) << ", "
+         << replications << " replications of " << args[0] << endl;
+    cout << "P(delay > " << setup.threshold << ") = " << probability << " +- " << 1.96 * std_error
+         << " (95%, relative error " << relative_error << ")" << endl;
+    cout << "packets per run " << mean_packets << ", late packets per run " << late / replications << endl;
+    cout << trajectories << " trajectories, " << steps << " steps in " << secs << "sec, work-normalized variance "
+         << relative_error * relative_error * secs << endl;
+    return 0;
+}
@@ -14,6 +14,8 @@
 #include <chrono>
 #include <algorithm>
 #include <string>
+#include <vector>
+#include <thread>
 
 #include <cadmium/modeling/coupling.hpp>
 #include <cadmium/modeling/ports.hpp>
@@ -30,10 +32,16 @@
 
 #include "../include/data_structures/message.hpp"
 #include "../include/simulator_renaissance.hpp"
+#include "../include/trace_reader.hpp"
+#include "../include/trace_filter.hpp"
+#include "../include/trace_index.hpp"
+#include "../include/mem_instrumentation.hpp"
+#include "../include/abp_batch.hpp"
 
 #include "../include/sender_cadmium.hpp"
 #include "../include/receiver_cadmium.hpp"
 #include "../include/subnet_cadmium.hpp"
+#include "../include/abp_topology.hpp"
 
 
 using namespace std;
@@ -47,42 +55,16 @@ char output_file[] = "./data/abp_output.txt";
 char mod_output_file[] = "./data/file_mod_output.csv";
 /**Output file path of the function output_time_statistics*/
 char time_statistics_file[] = "./data/time_stats_output.csv";
-
-
-/**
- * Setting input ports for messages
- */
-struct inp_control : public cadmium::in_port<message_t> {};
-struct inp_1 : public cadmium::in_port<message_t> {};
-struct inp_2 : public cadmium::in_port<message_t> {};
-
-/**
- * Setting output ports for messages 
- */
-struct outp_ack : public cadmium::out_port<message_t> {};
-struct outp_1 : public cadmium::out_port<message_t> {};
-struct outp_2 : public cadmium::out_port<message_t> {};
-struct outp_pack : public cadmium::out_port<message_t> {};
-
-
-/**
- * Now we declare the application generator class which is taking file path.
- * It is taking parameter and waits for input.
- * @tParam message T
- */
-template<typename T>
-class ApplicationGen : public iestream_input<message_t,T>{
-    public:
-    ApplicationGen() = default;
-    /**
-     * For class application generator , a parameterized constructor created.
-     * It takes input path of the file that has the input for ruuning the application.
-     * @param file_path
-     */
-    ApplicationGen(const char* file_path) : iestream_input<message_t,T>(file_path) {}
-
-};
-
+/**Output file path of the function output_delivery_report*/
+char delivery_report_file[] = "./data/delivery_report.csv";
+/**Output file path of the timeline written by output_file_evolution*/
+char timeline_file[] = "./data/timeline.csv";
+/**Output directory template of the batch mode, {name} is the name of the input*/
+char batch_output_template[] = "./data/batch/{name}";
+/**Summary table of the batch mode*/
+char batch_summary_file[] = "./data/batch/batch_summary.csv";
+/**Run metrics file, the measures of every phase are appended to it*/
+char run_metrics_file[] = "./data/run_metrics.csv";
 
 
 /**\brief  main function
@@ -100,12 +82,101 @@ class ApplicationGen : public iestream_input<message_t,T>{
  */
 int main(int argc, char ** argv){
 
-    if (argc < 2){
+    /**
+     * Capture options (--window t0 t1, --models a,b, --exclude-models a,b, --ports p,q)
+     * may appear anywhere on the command line and restrict what is written to the
+     * trace, see trace_filter.hpp. --flat runs the models with the flat kernel
+     * (flat_kernel.hpp) instead of the cadmium runner. --bucket t sets the width of the
+     * buckets of the timeline (default 00:01:00:000). --index N writes the offset of
+     * every Nth timestamp of the trace next to it (see trace_index.hpp). --batch runs
+     * many control inputs, --threads N of them at the same time (see abp_batch.hpp).
+     * The other arguments are positional.
+     */
+    trace_filter capture;
+    bool flat = false;
+    bool batch = false;
+    int threads = (int) thread::hardware_concurrency();
+    long long bucket_ms = 60000;
+    long index_every = 0;
+    vector<string> args;
+    for (int i = 1; i < argc; i++) {
+        string option = argv[i];
+        if (option == "--flat") {
+            flat = true;
+        }else if (option == "--batch") {
+            batch = true;
+        }else if (option == "--threads" && i + 1 < argc) {
+            threads = max(1, atoi(argv[++i]));
+        }else if (option == "--bucket" && i + 1 < argc) {
+            bucket_ms = parse_time_ms(argv[++i]);
+            if (bucket_ms <= 0) {
+                cout << "invalid bucket width " << argv[i] << endl;
+                return 1;
+            }
+        }else if (option == "--index" && i + 1 < argc) {
+            index_every = atol(argv[++i]);
+            if (index_every <= 0) {
+                cout << "invalid index interval " << argv[i] << endl;
+                return 1;
+            }
+        }else if (option.compare(0, 2, "--") == 0) {
+            if (!parse_trace_filter_option(argc, argv, i, capture)) {
+                cout << "invalid capture option " << option << endl;
+                return 1;
+            }
+        }else {
+            args.push_back(option);
+        }
+    }
+
+    if (args.empty()){
         cout << "you are using this program with wrong parameters. Te program should be invoked as follow:";
-        cout << argv[0] << " path to the input file " << endl;
+        cout << argv[0] << " path to the input file [end time] [output directory] [capture options] [--flat] [--bucket t] [--index N]" << endl;
+        cout << "or " << argv[0] << " --batch directory, list file or inputs separated by commas [end time]"
+             << " [output directory template] [summary file] [--threads N] [--bucket t]" << endl;
         return 1; 
     }
 
+    /**
+     * The batch mode writes the outputs of every input to the directory of the template
+     * (default ./data/batch/{name}) and the summary of all the runs to one table.
+     */
+    if (batch) {
+        vector<string> inputs = batch_inputs(args[0]);
+        if (inputs.empty()) {
+            cout << "no control input found in " << args[0] << endl;
+            return 1;
+        }
+        return run_batch(inputs, (args.size() > 1) ? args[1] : "04:00:00:000",
+                         (args.size() > 2) ? args[2] : batch_output_template,
+                         (args.size() > 3) ? args[3] : batch_summary_file, threads, bucket_ms);
+    }
+
+    /**
+     * The optional second argument is the simulation end time (default 04:00:00:000) and
+     * the optional third argument is the directory the output files are written to
+     * (default ./data). The benchmark suite uses both to run scaled control inputs.
+     * Nothing is captured after the end of the capture window, so the run stops there.
+     */
+    string end_time = (args.size() > 1) ? args[1] : "04:00:00:000";
+    string output_dir = (args.size() > 2) ? args[2] : "";
+    if (capture.t1_ms >= 0 && capture.t1_ms < parse_time_ms(end_time)) {
+        end_time = format_time_ms(capture.t1_ms + 1);
+    }
+    string trace_path = output_dir.empty() ? output_file : output_dir + "/abp_output.txt";
+    string mod_output_path = output_dir.empty() ? mod_output_file : output_dir + "/file_mod_output.csv";
+    string time_statistics_path = output_dir.empty() ? time_statistics_file :
+                                  output_dir + "/time_stats_output.csv";
+    string delivery_report_path = output_dir.empty() ? delivery_report_file : output_dir + "/delivery_report.csv";
+    string timeline_path = output_dir.empty() ? timeline_file : output_dir + "/timeline.csv";
+    string run_metrics_path = output_dir.empty() ? run_metrics_file : output_dir + "/run_metrics.csv";
+
+    /**
+     * Every phase of the run (model, runner, simulation and post-processing) is measured,
+     * see mem_instrumentation.hpp. Allocations are counted with make MEM_INSTRUMENTATION=1.
+     */
+    phase_metrics metrics(flat ? "ABP --flat" : "ABP");
+
     auto start = hclock::now(); //to measure simulation execution time
 
     /**
@@ -113,7 +184,17 @@ int main(int argc, char ** argv){
      * It is storing them during execution time.
      * The file named as abp_output file showing the output data.
      */
-    static std::ofstream out_data(output_file);
+    static std::ofstream out_data(trace_path);
+    /** With --index N the trace is indexed as it is written, into abp_output.txt.idx */
+    static std::ofstream index_data;
+    if (index_every > 0) {
+        index_data.open(trace_path + ".idx");
+    }
+    static trace_index_stream indexed_data(out_data, index_data, max(index_every, 1L));
+    static std::ostream* trace_file = (index_every > 0) ? (std::ostream*) &indexed_data : &out_data;
+    /** With a capture filter the logger writes through trace_filter_stream */
+    static trace_filter_stream filtered_data(*trace_file, capture);
+    static std::ostream* trace_sink = capture.active() ? (std::ostream*) &filtered_data : trace_file;
 
      /**
      * The structure which is a common sink provider structure 
@@ -121,7 +202,7 @@ int main(int argc, char ** argv){
      */
     struct oss_sink_provider{
         static std::ostream& sink(){          
-            return out_data;
+            return *trace_sink;
 
         }
 
@@ -166,151 +247,51 @@ int main(int argc, char ** argv){
 
     /**
      * For the application to control input data, Passing first argument value to input.
-     * It is creating generator file to execute and for number of input times , it runs the execution.
+     * The TOP model (generator_con and the ABPSimulator with sender1, receiver1 and the
+     * Network of subnet1 and subnet2) is built by make_abp_top, see abp_topology.hpp.
      */
-    string input_data_control = argv[1];
+    string input_data_control = args[0];
     const char * i_input_data_control = input_data_control.c_str();
 
-    /**
-     * The generator which is initialized contain has output file path, time and producing 
-     * the output by passing given inputs
-     */
-    std::shared_ptr<cadmium::dynamic::modeling::model> generator_con =
-                                                                       cadmium::dynamic::translate::make_dynamic_atomic_model<ApplicationGen,
-                                                                       TIME,
-                                                                       const char* >("generator_con" ,
-                                                                       std::move(i_input_data_control));
-
-
-    /**
-     * Recognizing output data which is sent from sender1
-     */
-    std::shared_ptr<cadmium::dynamic::modeling::model> sender1 =
-                                                                 cadmium::dynamic::translate::make_dynamic_atomic_model<Sender,
-                                                                 TIME>("sender1");
-
-
-    /**
-     * Recognizing output data which is received from receiver1
-     */
-    std::shared_ptr<cadmium::dynamic::modeling::model> receiver1 = 
-                                                                   cadmium::dynamic::translate::make_dynamic_atomic_model<Receiver,
-                                                                   TIME>("receiver1");
-
-
-
-    /**
-     * Recognizing output data which is received from subnet1 and also from subnet2
-     */
-    std::shared_ptr<cadmium::dynamic::modeling::model> subnet1 =
-                                                                 cadmium::dynamic::translate::make_dynamic_atomic_model<Subnet,
-                                                                 TIME>("subnet1");
-    std::shared_ptr<cadmium::dynamic::modeling::model> subnet2 = 
-                                                                 cadmium::dynamic::translate::make_dynamic_atomic_model<Subnet,
-                                                                 TIME>("subnet2");
-
-    /**
-     * The operations of network input and output ports which are used for each time frame is going to be stored
-     * as a value and after that it is storing in the output file.
-     */
-    cadmium::dynamic::modeling::Ports iports_Network = {typeid(inp_1),typeid(inp_2)};
-    cadmium::dynamic::modeling::Ports oports_Network = {typeid(outp_1),typeid(outp_2)};
-    cadmium::dynamic::modeling::Models submodels_Network = {subnet1, subnet2};
-    cadmium::dynamic::modeling::EICs eics_Network = {
-        cadmium::dynamic::translate::make_EIC<inp_1, subnet_defs::in>("subnet1"),
-        cadmium::dynamic::translate::make_EIC<inp_2, subnet_defs::in>("subnet2")
-    };
-    cadmium::dynamic::modeling::EOCs eocs_Network = {
-        cadmium::dynamic::translate::make_EOC<subnet_defs::out,outp_1>("subnet1"),
-        cadmium::dynamic::translate::make_EOC<subnet_defs::out,outp_2>("subnet2")
-    };
-    cadmium::dynamic::modeling::ICs ics_Network = {};
-    std::shared_ptr<cadmium::dynamic::modeling::coupled<TIME>> NETWORK =
-                                                                         std::make_shared<cadmium::dynamic::modeling::coupled<TIME>>(
-                                                                         "Network", 
-                                                                         submodels_Network, 
-                                                                         iports_Network, 
-                                                                         oports_Network, 
-                                                                         eics_Network, 
-                                                                         eocs_Network, 
-                                                                         ics_Network 
-                                                                         );
-
-    /**
-     * The operations of network input and output control packet acknowledgement of ABP simulator input and output ports
-     * which are used for each time frame is going to be stored as a value and after that it is storing in the output file.
-     */
-    cadmium::dynamic::modeling::Ports iports_ABPSimulator = {typeid(inp_control)};
-    cadmium::dynamic::modeling::Ports oports_ABPSimulator = {typeid(outp_ack),typeid(outp_pack)};
-    cadmium::dynamic::modeling::Models submodels_ABPSimulator = {sender1, receiver1,NETWORK};
-    cadmium::dynamic::modeling::EICs eics_ABPSimulator = {
-        cadmium::dynamic::translate::make_EIC<inp_control, sender_defs::controlIn>("sender1")
-    };
-    cadmium::dynamic::modeling::EOCs eocs_ABPSimulator = {
-        cadmium::dynamic::translate::make_EOC<sender_defs::packetSentOut,outp_pack>("sender1"),
-        cadmium::dynamic::translate::make_EOC<sender_defs::ackReceivedOut,outp_ack>("sender1")
-    };
-    cadmium::dynamic::modeling::ICs ics_ABPSimulator = {
-        cadmium::dynamic::translate::make_IC<sender_defs::dataOut, inp_1>("sender1","Network"),
-        cadmium::dynamic::translate::make_IC<outp_2, sender_defs::ackIn>("Network","sender1"),
-        cadmium::dynamic::translate::make_IC<receiver_defs::out, inp_2>("receiver1","Network"),
-        cadmium::dynamic::translate::make_IC<outp_1, receiver_defs::in>("Network","receiver1")
-    };
-    std::shared_ptr<cadmium::dynamic::modeling::coupled<TIME>> ABPSimulator =
-                                                                              std::make_shared<cadmium::dynamic::modeling::coupled<TIME>>(
-                                                                              "ABPSimulator", 
-                                                                              submodels_ABPSimulator, 
-                                                                              iports_ABPSimulator, 
-                                                                              oports_ABPSimulator, 
-                                                                              eics_ABPSimulator, 
-                                                                              eocs_ABPSimulator, 
-                                                                              ics_ABPSimulator 
-                                                                              );
+    if (flat) {
+        metrics.begin("model");
+        flat_kernel<TIME> kernel(*trace_sink);
+        make_abp_flat(kernel, i_input_data_control);
+        auto elapsed1 = std::chrono::duration_cast<std::chrono::duration<double,
+                        std::ratio<1>>>(hclock::now() - start).count();
+        cout << "Flat Kernel Created. Elapsed time: " << elapsed1 << "sec" << endl;
+
+        cout << "Simulation starts" << endl;
+        metrics.begin("simulation");
+        kernel.run_until(NDTime(end_time.c_str()));
+        trace_sink->flush();
+        metrics.end();
+    }else {
+        metrics.begin("model");
+        std::shared_ptr<cadmium::dynamic::modeling::coupled<TIME>> TOP = make_abp_top<TIME>(i_input_data_control);
+
+        /**
+         * Create a model which is measuring elapsed time form creations in seconds during run time. Then create runner and measuring elapsed 
+         * time in seconds. Simulation starts and Also shows the time used to finish th simulation
+         * time took to complete the simulation which is run until end_time (04:00:00:000 by default).
+         */
+        auto elapsed1 = std::chrono::duration_cast<std::chrono::duration<double,
+                        std::ratio<1>>>(hclock::now() - start).count();
+        cout << "Model Created. Elapsed time: " << elapsed1 << "sec" << endl;
+        
+        metrics.begin("runner");
+        cadmium::dynamic::engine::runner<NDTime, logger_top> r(TOP, {0});
+        elapsed1 = std::chrono::duration_cast<std::chrono::duration<double,
+                   std::ratio<1>>>(hclock::now() - start).count();
+        cout << "Runner Created. Elapsed time: " << elapsed1 << "sec" << endl;
 
+        cout << "Simulation starts" << endl;
 
-    /**
-     * It is storing top values of top model operations which is used for each time frame and 
-     * then storing in output file
-     */
-    cadmium::dynamic::modeling::Ports iports_TOP = {};
-    cadmium::dynamic::modeling::Ports oports_TOP = {typeid(outp_pack),typeid(outp_ack)};
-    cadmium::dynamic::modeling::Models submodels_TOP = {generator_con, ABPSimulator};
-    cadmium::dynamic::modeling::EICs eics_TOP = {};
-    cadmium::dynamic::modeling::EOCs eocs_TOP = {
-        cadmium::dynamic::translate::make_EOC<outp_pack,outp_pack>("ABPSimulator"),
-        cadmium::dynamic::translate::make_EOC<outp_pack,outp_ack>("ABPSimulator")
-    };
-    cadmium::dynamic::modeling::ICs ics_TOP = {
-        cadmium::dynamic::translate::make_IC<iestream_input_defs<message_t>::out,inp_control>("generator_con","ABPSimulator")
-    };
-    std::shared_ptr<cadmium::dynamic::modeling::coupled<TIME>> TOP =
-                                                                     std::make_shared<cadmium::dynamic::modeling::coupled<TIME>>(
-                                                                     "TOP", 
-                                                                     submodels_TOP, 
-                                                                     iports_TOP, 
-                                                                     oports_TOP, 
-                                                                     eics_TOP, 
-                                                                     eocs_TOP, 
-                                                                     ics_TOP 
-                                                                     );
-
-    /**
-     * Create a model which is measuring elapsed time form creations in seconds during run time. Then create runner and measuring elapsed 
-     * time in seconds. Simulation starts and Also shows the time used to finish th simulation
-     * time took to complete the simulation which is run 04:00:00:000 time period.
-     */
-    auto elapsed1 = std::chrono::duration_cast<std::chrono::duration<double,
-                    std::ratio<1>>>(hclock::now() - start).count();
-    cout << "Model Created. Elapsed time: " << elapsed1 << "sec" << endl;
-    
-    cadmium::dynamic::engine::runner<NDTime, logger_top> r(TOP, {0});
-    elapsed1 = std::chrono::duration_cast<std::chrono::duration<double,
-               std::ratio<1>>>(hclock::now() - start).count();
-    cout << "Runner Created. Elapsed time: " << elapsed1 << "sec" << endl;
-
-    cout << "Simulation starts" << endl;
-
-    r.run_until(NDTime("04:00:00:000"));
+        metrics.begin("simulation");
+        r.run_until(NDTime(end_time.c_str()));
+        trace_sink->flush();
+        metrics.end();
+    }
     auto elapsed = std::chrono::duration_cast<std::chrono::duration<double,
                    std::ratio<1>>>(hclock::now() - start).count();
     cout << "Simulation took:" << elapsed << "sec" << endl;
@@ -320,8 +301,10 @@ int main(int argc, char ** argv){
      *
      * @param[in]      input_file   The input file is the ouput file of ABP or test sets
      * @param[in]      output_file  The output file is modified to more readable format
+     * The timeline of the run is computed in the same pass over the trace.
      */
-    output_file_evolution(output_file, mod_output_file);
+    metrics.begin("output_file_evolution");
+    output_file_evolution(&trace_path[0], &mod_output_path[0], &timeline_path[0], bucket_ms);
 
     /**
      * @brief      Time delay statistics
@@ -330,7 +313,21 @@ int main(int argc, char ** argv){
      * @param      mod_output_file   The input file is the ouput file of abp_mod_output function
      * @param      time_statistics_file  The output file is file containing statistics of time delay
      */
-    output_time_statistics(mod_output_file, time_statistics_file);
+    metrics.begin("output_time_statistics");
+    output_time_statistics(&mod_output_path[0], &time_statistics_path[0]);
+
+    /**
+     * @brief      Per packet delivery report
+     * First send, final ack, transmissions and delay of every packet at millisecond resolution
+     */
+    metrics.begin("output_delivery_report");
+    output_delivery_report(&mod_output_path[0], &delivery_report_path[0]);
+    metrics.end();
+
+    /** The events of the simulation are the messages of the trace */
+    metrics.set_events("simulation", count_csv_events(&mod_output_path[0]));
+    metrics.print(cout);
+    metrics.write(run_metrics_path);
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,235 @@
+/** /brief This source file contains the memory instrumentation of the simulator.
+ *
+ * See mem_instrumentation.hpp. The operator new and delete hooks are only
+ * compiled with -DABP_MEM_INSTRUMENTATION. The resident memory is read from
+ * /proc/self/status with stdio, so measuring a phase doesn't count as an
+ * allocation of it.
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <new>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <malloc.h>
+
+#include "../include/mem_instrumentation.hpp"
+
+using namespace std;
+
+static atomic<long long> allocation_count(0);
+static atomic<long long> free_count(0);
+static atomic<long long> allocated_bytes(0);
+static atomic<long long> live_bytes(0);
+static atomic<long long> peak_live_bytes(0);
+
+#ifdef ABP_MEM_INSTRUMENTATION
+
+/**
+ * @brief      Counts an allocation, the size is the usable size of the block so frees match it
+ */
+static void* counted_malloc(size_t size) {
+    void *p = malloc(size == 0 ? 1 : size);
+    if (p != nullptr) {
+        long long usable = malloc_usable_size(p);
+        allocation_count.fetch_add(1, memory_order_relaxed);
+        allocated_bytes.fetch_add(usable, memory_order_relaxed);
+        long long live = live_bytes.fetch_add(usable, memory_order_relaxed) + usable;
+        long long peak = peak_live_bytes.load(memory_order_relaxed);
+        while (live > peak && !peak_live_bytes.compare_exchange_weak(peak, live, memory_order_relaxed)) {}
+    }
+    return p;
+}
+
+static void counted_free(void *p) {
+    if (p != nullptr) {
+        free_count.fetch_add(1, memory_order_relaxed);
+        live_bytes.fetch_sub(malloc_usable_size(p), memory_order_relaxed);
+        free(p);
+    }
+}
+
+void* operator new(size_t size) {
+    void *p = counted_malloc(size);
+    if (p == nullptr) {
+        throw bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const nothrow_t &) noexcept {
+    return counted_malloc(size);
+}
+
+void* operator new[](size_t size, const nothrow_t &) noexcept {
+    return counted_malloc(size);
+}
+
+void operator delete(void *p) noexcept {
+    counted_free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    counted_free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    counted_free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+    counted_free(p);
+}
+
+bool mem_instrumentation_enabled() {
+    return true;
+}
+
+#else
+
+bool mem_instrumentation_enabled() {
+    return false;
+}
+
+#endif
+
+mem_counters mem_snapshot() {
+    mem_counters counters;
+    counters.allocations = allocation_count.load(memory_order_relaxed);
+    counters.frees = free_count.load(memory_order_relaxed);
+    counters.bytes = allocated_bytes.load(memory_order_relaxed);
+    counters.live_bytes = live_bytes.load(memory_order_relaxed);
+    counters.peak_live_bytes = peak_live_bytes.load(memory_order_relaxed);
+    return counters;
+}
+
+void reset_peak_live_bytes() {
+    peak_live_bytes.store(live_bytes.load(memory_order_relaxed), memory_order_relaxed);
+}
+
+/**
+ * @brief      Reads a field of /proc/self/status in kB
+ */
+static long read_status_kb(const char *field) {
+    FILE *status = fopen("/proc/self/status", "r");
+    if (status == nullptr) {
+        return -1;
+    }
+    char line[256];
+    long kb = -1;
+    size_t length = strlen(field);
+    while (fgets(line, sizeof(line), status) != nullptr) {
+        if (strncmp(line, field, length) == 0 && line[length] == ':') {
+            kb = atol(line + length + 1);
+            break;
+        }
+    }
+    fclose(status);
+    return kb;
+}
+
+long current_rss_kb() {
+    return read_status_kb("VmRSS");
+}
+
+long peak_rss_kb() {
+    return read_status_kb("VmHWM");
+}
+
+bool reset_peak_rss() {
+    FILE *clear_refs = fopen("/proc/self/clear_refs", "w");
+    if (clear_refs == nullptr) {
+        return false;
+    }
+    bool reset = fputs("5", clear_refs) >= 0;
+    reset &= fclose(clear_refs) == 0;
+    return reset;
+}
+
+phase_metrics::phase_metrics(const string &i_program) : program(i_program) {}
+
+void phase_metrics::begin(const string &phase) {
+    end();
+    phase_record record;
+    record.phase = phase;
+    records.push_back(record);
+    reset_peak_rss();
+    reset_peak_live_bytes();
+    running = true;
+    start_counters = mem_snapshot();
+    start = chrono::high_resolution_clock::now();
+}
+
+void phase_metrics::end() {
+    if (!running) {
+        return;
+    }
+    auto stop = chrono::high_resolution_clock::now();
+    mem_counters counters = mem_snapshot();
+    running = false;
+    phase_record &record = records.back();
+    record.secs = chrono::duration_cast<chrono::duration<double, ratio<1>>>(stop - start).count();
+    record.allocations = counters.allocations - start_counters.allocations;
+    record.bytes = counters.bytes - start_counters.bytes;
+    record.peak_heap_bytes = counters.peak_live_bytes;
+    record.peak_rss_kb = peak_rss_kb();
+}
+
+void phase_metrics::set_events(const string &phase, long long events) {
+    for (phase_record &record : records) {
+        if (record.phase == phase) {
+            record.events = events;
+        }
+    }
+}
+
+const vector<phase_record>& phase_metrics::phases() const {
+    return records;
+}
+
+bool phase_metrics::write(const string &path) const {
+    bool new_file = !ifstream(path).good();
+    ofstream o_d_stream(path, ofstream::out | ofstream::app);
+    if (!o_d_stream.is_open()) {
+        return false;
+    }
+    if (new_file) {
+        o_d_stream << "Program,Phase,Secs,Allocations,Bytes,PeakHeapBytes,PeakRSSkB,Events,AllocsPerEvent" << endl;
+    }
+    for (const phase_record &record : records) {
+        o_d_stream << program << "," << record.phase << "," << record.secs << "," << record.allocations << ","
+                   << record.bytes << "," << record.peak_heap_bytes << "," << record.peak_rss_kb << ","
+                   << record.events << ",";
+        if (record.events > 0) {
+            o_d_stream << (double) record.allocations / record.events;
+        }
+        o_d_stream << endl;
+    }
+    return true;
+}
+
+void phase_metrics::print(ostream &os) const {
+    os << left << setw(24) << "phase" << setw(12) << "secs" << setw(14) << "allocations"
+       << setw(14) << "bytes" << setw(16) << "peak heap B" << "peak RSS kB" << endl;
+    for (const phase_record &record : records) {
+        os << left << setw(24) << record.phase << setw(12) << record.secs << setw(14) << record.allocations
+           << setw(14) << record.bytes << setw(16) << record.peak_heap_bytes << record.peak_rss_kb << endl;
+    }
+    if (!mem_instrumentation_enabled()) {
+        os << "(allocations are counted when built with make MEM_INSTRUMENTATION=1)" << endl;
+    }
+}
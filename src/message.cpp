@@ -14,12 +14,16 @@
 
 /** Output stream
  * It is an operator used to apply on an output stream  which is called insertion operator and
- * performing output character sequence in a proper format
+ * performing output character sequence in a proper format. The flow is written as
+ * value@flow, only when it is not 0, so single pair traces are unchanged.
  * @param[out] os reference to an output stream named as ostream.
  * @param[in] msg constant which is a reference to a message named as struct message_t.
  */
 ostream& operator<<(ostream& os, const message_t& msg) {
 	os << msg.value;
+	if (msg.flow != 0) {
+		os << "@" << msg.flow;
+	}
 	return os;
 }
 
@@ -31,5 +35,10 @@ ostream& operator<<(ostream& os, const message_t& msg) {
  */
 istream& operator>> (istream& is, message_t& msg) {
 	is >> msg.value;
+	msg.flow = 0;
+	if (is.good() && is.peek() == '@') {
+		is.get();
+		is >> msg.flow;
+	}
     return is;
 }
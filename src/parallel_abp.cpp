@@ -0,0 +1,171 @@
+/** \brief Parallel simulation of M independent ABP pairs
+ *
+ * Runs M copies of the ABP simulator (make_abp_pairs_top in abp_topology.hpp)
+ * with the parallel runner of parallel_runner.hpp, one partition of pairs per
+ * thread, and writes to the output directory:
+ *      - parallel_M_output.txt       merged trace of the run
+ *      - parallel_M_mod_output.csv   trace in csv format (output_file_evolution)
+ *
+ * With --sequential the pairs are run by one cadmium runner instead. With --verify
+ * both runs are made and the traces are compared, the program fails if they differ.
+ *
+ * Usage: ./bin/ABP_PARALLEL <control input> [end time] [M] [threads] [output directory]
+ *                           [--sequential | --verify]
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <thread>
+#include <sys/stat.h>
+
+#include <cadmium/engine/pdevs_dynamic_runner.hpp>
+#include <cadmium/logger/tuple_to_ostream.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+#include "../lib/DESTimes/include/NDTime.hpp"
+
+#include "../include/simulator_renaissance.hpp"
+#include "../include/thread_sink.hpp"
+#include "../include/abp_topology.hpp"
+#include "../include/parallel_runner.hpp"
+
+using namespace std;
+
+using hclock=chrono::high_resolution_clock;
+using TIME = NDTime;
+
+/**Default directory of the outputs*/
+char parallel_output_directory[] = "./data/parallel";
+
+/**
+ * @brief      Runs the pairs with one cadmium runner
+ */
+static void run_sequential(const string &input, int pairs, const string &end_time, ostream &o_d_stream) {
+    thread_sink_guard guard(o_d_stream);
+    auto TOP = make_abp_pairs_top<TIME>(input.c_str(), 1, pairs);
+    cadmium::dynamic::engine::runner<NDTime, thread_logger_top<NDTime>> r(TOP, {0});
+    r.run_until(NDTime(end_time.c_str()));
+    o_d_stream.flush();
+}
+
+/**
+ * @brief      Runs the pairs with the parallel runner
+ */
+static void run_parallel(const string &input, int pairs, int threads, const string &end_time,
+                         ostream &o_d_stream) {
+    parallel_runner<TIME> r(input, pairs, threads);
+    r.run_until(NDTime(end_time.c_str()), o_d_stream);
+}
+
+/**
+ * @brief      Compares two traces line by line
+ * @return     0 if equal, otherwise the first line which differs
+ */
+static int compare_traces(const string &left, const string &right) {
+    istringstream left_stream(left), right_stream(right);
+    string left_line, right_line;
+    int line = 0;
+    while (true) {
+        ++line;
+        bool has_left = static_cast<bool>(getline(left_stream, left_line));
+        bool has_right = static_cast<bool>(getline(right_stream, right_line));
+        if (!has_left && !has_right) {
+            return 0;
+        }
+        if (has_left != has_right || left_line != right_line) {
+            return line;
+        }
+    }
+}
+
+/**\brief  main function
+ *
+ * @param argc Integer argument - These are counting the command line arguments
+ * @param argv Argument vector - control input, end time, M, threads, output directory and options
+ */
+int main(int argc, char ** argv){
+
+    bool sequential = false;
+    bool verify = false;
+    vector<string> args;
+    for (int i = 1; i < argc; i++) {
+        string option = argv[i];
+        if (option == "--sequential") {
+            sequential = true;
+        }else if (option == "--verify") {
+            verify = true;
+        }else if (option.compare(0, 2, "--") == 0) {
+            cout << "invalid option " << option << endl;
+            return 1;
+        }else {
+            args.push_back(option);
+        }
+    }
+    if (args.empty()){
+        cout << "you are using this program with wrong parameters. The program should be invoked as follow:";
+        cout << argv[0] << " path to the input file [end time] [M] [threads] [output directory]"
+             << " [--sequential | --verify]" << endl;
+        return 1;
+    }
+    string input_data_control = args[0];
+    string end_time = (args.size() > 1) ? args[1] : "04:00:00:000";
+    int pairs = (args.size() > 2) ? stoi(args[2]) : 8;
+    int threads = (args.size() > 3) ? stoi(args[3]) : (int) thread::hardware_concurrency();
+    string output_dir = (args.size() > 4) ? args[4] : parallel_output_directory;
+    if (pairs < 1 || threads < 1) {
+        cout << "M and threads must be at least 1" << endl;
+        return 1;
+    }
+    mkdir(output_dir.c_str(), 0755);
+
+    string prefix = output_dir + "/parallel_" + to_string(pairs);
+    string trace_path = prefix + "_output.txt";
+    string mod_output_path = prefix + "_mod_output.csv";
+
+    if (verify) {
+        ostringstream sequential_trace, parallel_trace;
+        auto start = hclock::now();
+        run_sequential(input_data_control, pairs, end_time, sequential_trace);
+        double sequential_secs = chrono::duration_cast<chrono::duration<double, ratio<1>>>(hclock::now() - start).count();
+        start = hclock::now();
+        run_parallel(input_data_control, pairs, threads, end_time, parallel_trace);
+        double parallel_secs = chrono::duration_cast<chrono::duration<double, ratio<1>>>(hclock::now() - start).count();
+
+        ofstream out_data(trace_path);
+        out_data << parallel_trace.str();
+        int line = compare_traces(sequential_trace.str(), parallel_trace.str());
+        cout << "M=" << pairs << ": sequential " << sequential_secs << "sec, parallel "
+             << parallel_secs << "sec on " << min(threads, pairs) << " threads" << endl;
+        if (line != 0) {
+            cout << "traces differ at line " << line << endl;
+            return 1;
+        }
+        cout << "traces are identical" << endl;
+    }else {
+        auto start = hclock::now();
+        {
+            ofstream out_data(trace_path);
+            if (sequential) {
+                run_sequential(input_data_control, pairs, end_time, out_data);
+            }else {
+                run_parallel(input_data_control, pairs, threads, end_time, out_data);
+            }
+        }
+        double secs = chrono::duration_cast<chrono::duration<double, ratio<1>>>(hclock::now() - start).count();
+        cout << "M=" << pairs << ": " << (sequential ? "sequential" : "parallel") << " run took "
+             << secs << "sec" << endl;
+    }
+
+    output_file_evolution(&trace_path[0], &mod_output_path[0]);
+    cout << "Trace written to " << trace_path << endl;
+    return 0;
+}
@@ -0,0 +1,110 @@
+/** \brief Shared bottleneck link simulation
+ *
+ * Runs M sender/receiver pairs contending for one queued link in each direction
+ * (see make_shared_link_top in abp_topology.hpp) for every M of a list. For every M
+ * it writes to the output directory:
+ *      - shared_M_output.txt       trace of the run
+ *      - shared_M_mod_output.csv   trace in csv format (output_file_evolution)
+ *      - shared_M_flows.csv        goodput of every flow and fairness (output_flow_statistics)
+ * and adds a row to shared_link_cost.csv showing how the simulation cost grows with M.
+ *
+ * Usage: ./bin/ABP_SHARED <control input> [end time] [M list, e.g. 1,2,4,8] [output directory]
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+#include <cadmium/engine/pdevs_dynamic_runner.hpp>
+#include <cadmium/logger/tuple_to_ostream.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+#include "../lib/DESTimes/include/NDTime.hpp"
+
+#include "../include/simulator_renaissance.hpp"
+#include "../include/trace_reader.hpp"
+#include "../include/thread_sink.hpp"
+#include "../include/abp_topology.hpp"
+
+using namespace std;
+
+using hclock=chrono::high_resolution_clock;
+using TIME = NDTime;
+
+/**Default directory of the outputs*/
+char shared_output_directory[] = "./data/shared";
+
+/**\brief  main function
+ *
+ * @param argc Integer argument - These are counting the command line arguments
+ * @param argv Argument vector - control input, end time, list of M and output directory
+ */
+int main(int argc, char ** argv){
+
+    if (argc < 2){
+        cout << "you are using this program with wrong parameters. The program should be invoked as follow:";
+        cout << argv[0] << " path to the input file [end time] [M list] [output directory]" << endl;
+        return 1;
+    }
+    string input_data_control = argv[1];
+    string end_time = (argc > 2) ? argv[2] : "04:00:00:000";
+    long long horizon_ms = parse_time_ms(end_time);
+    if (horizon_ms <= 0) {
+        cout << "invalid end time " << end_time << endl;
+        return 1;
+    }
+    vector<string> flow_counts = split((argc > 3) ? argv[3] : "1,2,4,8", ',');
+    string output_dir = (argc > 4) ? argv[4] : shared_output_directory;
+    mkdir(output_dir.c_str(), 0755);
+
+    string cost_path = output_dir + "/shared_link_cost.csv";
+    ofstream cost_stream(cost_path, ofstream::out | ofstream::trunc);
+    cost_stream << "Flows,ModelSecs,RunSecs,Events,EventsPerSec" << endl;
+
+    for (const string &flow_count : flow_counts) {
+        int flows = stoi(flow_count);
+        string prefix = output_dir + "/shared_" + flow_count;
+        string trace_path = prefix + "_output.txt";
+        string mod_output_path = prefix + "_mod_output.csv";
+        string flows_path = prefix + "_flows.csv";
+
+        auto start = hclock::now();
+        auto TOP = make_shared_link_top<TIME>(flows, input_data_control.c_str());
+        double model_secs = chrono::duration_cast<chrono::duration<double, ratio<1>>>(hclock::now() - start).count();
+
+        start = hclock::now();
+        {
+            ofstream out_data(trace_path);
+            thread_sink_guard guard(out_data);
+            cadmium::dynamic::engine::runner<NDTime, thread_logger_top<NDTime>> r(TOP, {0});
+            r.run_until(NDTime(end_time.c_str()));
+        }
+        double run_secs = chrono::duration_cast<chrono::duration<double, ratio<1>>>(hclock::now() - start).count();
+
+        output_file_evolution(&trace_path[0], &mod_output_path[0]);
+        output_flow_statistics(&mod_output_path[0], &flows_path[0], horizon_ms);
+
+        /** Events are the messages of the trace, one csv row each */
+        long events = count_csv_events(&mod_output_path[0]);
+
+        cout << "M=" << flows << ": model " << model_secs << "sec, run " << run_secs << "sec, "
+             << events << " events" << endl;
+        ifstream flows_stream(flows_path);
+        string line;
+        while (getline(flows_stream, line)) {
+            cout << "  " << line << endl;
+        }
+        cost_stream << flows << "," << model_secs << "," << run_secs << "," << events << ","
+                    << (run_secs > 0 ? events / run_secs : 0) << endl;
+    }
+    cout << "Simulation cost per M written to " << cost_path << endl;
+    return 0;
+}
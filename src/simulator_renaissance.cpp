@@ -44,23 +44,136 @@
 #include <vector>
 #include <unistd.h>
 #include <cmath>
+#include <map>
+#include <deque>
+#include <algorithm>
 
 #include "../include/simulator_renaissance.hpp"
+#include "../include/trace_scan.hpp"
+#include "../include/data_structures/message.hpp"
 
 using namespace std;
 
 /**
- * This function which is taking string as input and giving output as strings.
- * which is making the output in good format for human visualziation.
+ * Stream version of output_file_evolution, it does the parsing for the file version
+ * and lets the test driver convert in-memory traces without touching the file system.
  */
-void output_file_evolution(char input_file[], char output_file[]) {
+void output_file_evolution(istream &i_d_stream, ostream &o_d_stream, trace_timeline *timeline) {
 	/**
 	 * String variables to store the parsed sub-strings
 	 */
-    string line, time, component, comma = ",";
-    int arr[5] = { 0 }, /**< arr array stores the position of comma occured in string */
-     	counter = 0, val_pos = 0, scope_resl_op = 0;  /**<  Different variables initialized for later use */
+    string line, time;
+    trace_line_scan scan; /**< Positions of the structural characters of the line, reused for every line */
+
+    /** Writes the strings on the first line of the output file */
+    o_d_stream << "Time" << "," << "Value" << "," <<
+                  "Port" << "," << "Component" << endl; 
+
+    /**
+     * While loop runs until the End-of-File is encounterd. i_d_stream.eof() returns true 
+     * when the End-of-File has been reached by the last input operation.
+     */
+    while (!i_d_stream.eof()) {
+    	/**
+    	 * getline reads the first line via the i_d_stream, and stores it in string line.
+    	 */
+        getline(i_d_stream, line);
+        /**
+         * If the length of the line read from the previous command equals 12(if statement),
+         * it means that the string is time. This is what is checked in the if statement
+         * and the line is copied to the time string.
+         * Otherwise if the length of the line is greater than 12(else if statement),
+         * then the block parses the string for the required pattern.
+         */
+        if (line.length() == 12) {
+           time = line;
+        }else if (line.length() > 12) {
+            /**
+             * scan_trace_line finds the commas, braces, colons and brackets of the line in
+             * one pass (trace_scan.hpp), the fields are then cut between those positions.
+             */
+            scan_trace_line(line.data(), line.size(), scan);
+            /**
+             * A model which generated no message prints "[]", the line is skipped.
+             * Otherwise, the block tries to parse the string for the required pattern.
+             */
+            bool empty_bag = false;
+            for (uint32_t square : scan.squares_open) {
+                empty_bag = empty_bag || (square + 1 < line.size() && line[square + 1] == ']');
+            }
+            if (empty_bag) {
+                continue;
+            }
+            /**
+             * The name of the model follows "model " after the bag of the line, which
+             * ends with its last ']'.
+             */
+            size_t bag_end = scan.squares_close.empty() ? 0 : scan.squares_close.back();
+            string component_check = line.substr(line.find("model", bag_end) + 6);
+            bool has_value = false;           /**<  Whether the model generated a message */
+
+            /**
+             * The messages of every port are between a "{" and the first "}" from there,
+             * separated by ", " when several arrived at the same time, and the name of the
+             * port between the first "::" after the previous port and the ":" following it.
+             * Every message is written on its own row.
+             */
+            bool damaged = false;             /**<  Whether the model generated a damaged message */
+            size_t port_start = 0;
+            for (uint32_t val_pos : scan.braces_open) {
+                size_t val_end = trace_scan_next(scan.braces_close, val_pos);
+                if (val_end == SIZE_MAX) {
+                    break;
+                }
+                size_t name_start = port_start;
+                port_start = val_end;
+                /** A port without message value is skipped */
+                if (val_end == val_pos + 1) {
+                    continue;
+                }
+                /** First "::", a colon followed by another one */
+                size_t scope_resl_op = string::npos;
+                for (size_t colon = trace_scan_next(scan.colons, name_start); colon != string::npos;
+                     colon = trace_scan_next(scan.colons, colon + 1)) {
+                    if (colon + 1 < line.size() && line[colon + 1] == ':') {
+                        scope_resl_op = colon;
+                        break;
+                    }
+                }
+                string port = line.substr(scope_resl_op + 2,
+                                          trace_scan_next(scan.colons, scope_resl_op + 2) - scope_resl_op - 2);
+                for (size_t value_start = val_pos + 1; value_start < val_end; ) {
+                    size_t value_end = min(trace_scan_next(scan.commas, value_start), val_end);
+                    string value = line.substr(value_start, value_end - value_start);
+                    value_start = value_end + 1;
+                    while (value_start < val_end && line[value_start] == ' ') {
+                        ++value_start;
+                    }
+                    /**The following line writes parsed strings to the output via o_d_stream object*/
+                    o_d_stream << time << "," << value << "," << port << "," << component_check << endl;
+                    has_value = true;
+                    damaged = damaged || value == "-1";
+                    if (timeline != nullptr) {
+                        timeline->add(time, value, port, component_check);
+                    }
+                }
+            }
 
+            /** An imminent subnet which generated no message, or a damaged one, has lost its packet */
+            if (timeline != nullptr && (!has_value || damaged)
+                && component_check.compare(0, 6, "subnet") == 0) {
+                timeline->drop(time, component_check);
+            }
+        }
+    }
+}
+
+/**
+ * This function which is taking string as input and giving output as strings.
+ * which is making the output in good format for human visualziation. The timeline,
+ * if not null, is filled in the same pass.
+ */
+static void output_file_evolution(char input_file[], char output_file[], trace_timeline *timeline) {
     /**
      * @brief      If block to check file existence
      * If the file doesn't exist then the stat function returns -1 in the if condition,
@@ -108,96 +221,7 @@ void output_file_evolution(char input_file[], char output_file[]) {
         cout << "The real problem is not whether machines " 
              <<  "think but whether men do." << endl;
 
-        /** Writes the strings on the first line of the output file */
-        o_d_stream << "Time" << "," << "Value" << "," <<
-                      "Port" << "," << "Component" << endl; 
-
-        /**
-         * While loop runs until the End-of-File is encounterd. i_d_stream.eof() returns true 
-         * when the End-of-File has been reached by the last input operation.
-         */
-        while (!i_d_stream.eof()) {
-        	/**
-        	 * getline reads the first line via the i_d_stream, and stores it in string line.
-        	 */
-            getline(i_d_stream, line);
-            /**
-             * If the length of the line read from the previous command equals 12(if statement),
-             * it means that the string is time. This is what is checked in the if statement
-             * and the line is copied to the time string.
-             * Otherwise if the length of the line is greater than 12(else if statement),
-             * then the block parses the string for the required pattern.
-             */
-            if (line.length() == 12) {
-               time = line;
-            }else if (line.length() > 12) {
-                string payload = line; /**<  string line is copied to string payload */
-                /** 
-                 * .find() returns the index of the first occurrence of the substring("[]")
-                 *  in the string (payload) from the start.
-                 *  If the substring is found it returns std::string::npos which means -1. The
-                 *  following if conditional block checks for it, and if the statement becomes true,
-                 *  then the "continue", statement executes, and the code handle returns to while block.
-                 *  Otherwise, the block tries to parse the string for the required pattern.
-                */
-                size_t mes_status = payload.find("[]");
-                if (mes_status != std::string::npos) {
-                    continue;
-                }else{
-                    std::fill_n(arr, 5, 0); 		  /**<  Resets the arr elements with 0 */
-                    counter = 0;                      /**<  counter is reset */
-                    size_t pos = payload.find(comma); /**<  Finds the first occurence of comma in payload */
-                    while (pos != std::string::npos)  /**<  Keep running until there is no comma */
-                    {
-                        arr[counter + 1] = pos;       /**<  Store the location of first comma at position 1 in arr */
-                        ++counter; 				      /**< Increment the counter by 1 */
-                        pos = payload.find(comma, pos + comma.size()); /** Look for the next occurrence of comma starting after the 
-                                                                        * first occurrence of the previous comma*/
-                    }
-                    /**
-                     * The following line finds the position of model (payload.find("model")) in
-                     * the payload, and that position is added to (6) include the length of model
-                     * and space. This becomes the parameter of (.substr()) which returns the substring
-                     * starting from this parameter position till the end-of-line.
-                     */
-                    string component_check = payload.substr(payload.find("model") + 6);
-                    counter = 0;				      /**<  counter is reset */
-                    
-                    /**
-                     * The following do-while loop works until the first 0 is encountered in arr
-                     * starting after the 0th element position
-                     * Find the first "{" position starting from arr value position
-                     * Returns the substring between {} and stores it in string value
-                     */
-                    do {
-                        val_pos = payload.find("{", arr[counter]); 
-                        string value = payload.substr(val_pos + 1, payload.find("}", 
-                        							  arr[counter]) - val_pos - 1);	
-
-                        /** If the previous line returns "" (meaning no message value), then the if condition
-                        * becomes true and the "continue", statement executes, returning the code handle to while block.
-                        * returning the code handle to while block.
-                        * Otherwise code continues with the task of parsing.
-                        */                              	
-                        if (value == "") {
-                            continue;		
-                        }else{					
-                        	scope_resl_op = payload.find("::", arr[counter]);
-                            /**< Find the first "::" position starting from arr value position */
-                            /** The following line returns the substring between "::" and ":". 
-                             * It then stores it in string port
-                             */
-                            string port = payload.substr(scope_resl_op + 2,
-                            							((payload.find(":", scope_resl_op + 2) - scope_resl_op) - 2));
-                            /**The following line writes parsed strings to the output via o_d_stream object*/
-                            o_d_stream << time << "," << value << "," << port << "," << component_check << endl;
-                        }
-                    } while (arr[++counter] != 0); /**< Keep running till 0 is encountered */
-
-                }
-            }
-        }
-
+        output_file_evolution(i_d_stream, o_d_stream, timeline);
     }else{
     	cout << "Files are not opened" << endl;
     }
@@ -207,6 +231,25 @@ void output_file_evolution(char input_file[], char output_file[]) {
 
 }
 
+void output_file_evolution(char input_file[], char output_file[]) {
+    output_file_evolution(input_file, output_file, nullptr);
+}
+
+/**
+ * output_file_evolution computing the timeline of the run in the same pass
+ * and writing it to timeline_file.
+ */
+void output_file_evolution(char input_file[], char output_file[], char timeline_file[], long long bucket_ms) {
+    trace_timeline timeline(bucket_ms);
+    output_file_evolution(input_file, output_file, &timeline);
+    ofstream o_d_stream(timeline_file, ofstream::out | ofstream::trunc);
+    if (!o_d_stream.is_open()) {
+        cout << timeline_file << " is not opened" << endl;
+        return;
+    }
+    timeline.write(o_d_stream);
+}
+
 /**
 *The function which takes string for splitting and also checking specific delimters
 * and in output giving vecor of strings work as a string splitter.
@@ -223,6 +266,26 @@ vector<string> split(const string &s, char delim) {
     return result;
 }
 
+/**
+ * Converts a HH:MM:SS:mmm time of the csv to milliseconds, -1 if it isn't one.
+ * Times of the usual width go through parse_fixed_time_ms, longer ones (after
+ * 99 hours) through split.
+ */
+static long long time_to_ms(const char *time_chars, size_t length) {
+    if (length == 12) {
+        return parse_fixed_time_ms(time_chars);
+    }
+    vector<string> time = split(string(time_chars, length), ':');
+    if (time.size() != 4) {
+        return -1;
+    }
+    return ((stoll(time[0]) * 60 + stoll(time[1])) * 60 + stoll(time[2])) * 1000 + stoll(time[3]);
+}
+
+static long long time_to_ms(const string &time_string) {
+    return time_to_ms(time_string.data(), time_string.size());
+}
+
 /**
 * The function which is taking the input as string and output as string
 * which is behaving as function calculating time statistics
@@ -231,6 +294,7 @@ void output_time_statistics(char input_file[], char output_file[]) {
 
     /** String variables to store the parsed sub-strings */
     string payload, time_delay, max_time, min_time, avg_time;
+    trace_line_scan scan; /**< Positions of the commas of the line, reused for every line */
 
     /**< Different variables initialized for later use */
     int main_counter = 1, counter = 0,
@@ -305,33 +369,39 @@ void output_time_statistics(char input_file[], char output_file[]) {
                 continue;
             }
             /**
-             * The following line splits the string payload using delimiter ",", and returns the string
-             * vector and stores it in "payload_vec" vector. 
+             * The following line finds the commas of the string payload in one pass (trace_scan.hpp),
+             * the fields are cut between them instead of being split into a vector of strings.
              * The format is, 0-Time, 1-Value, 2-Port, and 3-Component.
              */
-            vector<string> payload_vec = split(payload, ','); /**< Payload Vector */
+            scan_trace_line(payload.data(), payload.size(), scan);
+            if (scan.commas.size() < 2) {
+                continue;
+            }
+            size_t time_end = scan.commas[0], value_end = scan.commas[1];
+            size_t port_end = (scan.commas.size() > 2) ? scan.commas[2] : payload.size();
             /**
-             * The following conditional block checks whether the 3rd element of payload_vect is "dataOut"
+             * The following conditional block checks whether the port field is "dataOut"
              * or "ackReceivedOut", otherwise in else block continue statement executes, returning the code handle to while block.
              * If it's "dataOut", then the if condition becomes true. Following it, the nested if block checks whether the 
              * current mes_value is equal to the previous read mes_value or not. On true, the "continue"
              * statement executes, returning the code handle to while block.
              */
-            if (payload_vec[2] == "dataOut") {
-                if (mes_value == stoi(payload_vec[1])) {
+            if (payload.compare(value_end + 1, port_end - value_end - 1, "dataOut") == 0) {
+                int value = atoi(payload.c_str() + time_end + 1); /**< Converts value from string to int */
+                if (mes_value == value) {
                     continue;
                 }
-                mes_value = stoi(payload_vec[1]); /**< Converts value from string to int */
-                vector<string> time = split(payload_vec[0], ':'); /**< Splits the payload_vec[0](time) string on delimiter ':' */
-                dataout_time_secs = (stoi(time[0]) * 3600) + (stoi(time[1]) * 60) + stoi(time[2]); /**< Calculates the total number of secs */
-            }else if (payload_vec[2] == "ackReceivedOut") {
+                mes_value = value;
+                /** Calculates the total number of secs of the time field */
+                dataout_time_secs = (int) (time_to_ms(payload.data(), time_end) / 1000);
+            }else if (payload.compare(value_end + 1, port_end - value_end - 1, "ackReceivedOut") == 0) {
                 ++counter; /**< Increment the counter by 1 */
-                vector<string> time = split(payload_vec[0], ':'); /**< Splits the payload_vec[0](time) string on delimiter ':' */
-                ackRec_time_secs = (stoi(time[0]) * 3600) + (stoi(time[1]) * 60) + stoi(time[2]); /**< Calculates the total number of secs */
+                /** Calculates the total number of secs of the time field */
+                ackRec_time_secs = (int) (time_to_ms(payload.data(), time_end) / 1000);
                 /** Calculates the difference(no. of seconds) between the dataOut(sender) and ackReceivedOut(receiver) */
                 time_secs  = ackRec_time_secs - dataout_time_secs; /**< Total number of seconds */
                 /**Converts the total seconds to the time format of string type, and saves it in time_delay.*/
-                time_delay = to_string(time_secs / 3600) + ":" + to_string(time_secs / 60) + ":" + to_string(time_secs % 60);
+                time_delay = to_string(time_secs / 3600) + ":" + to_string((time_secs / 60) % 60) + ":" + to_string(time_secs % 60);
                 total_secs += time_secs; /**< Adds the current time seconds to the total time seconds for calculating average time later */
                 /**
                  * If the counter is equal to 1, i.e. the first time this elseif block is executing, then set the max and min seconds to 
@@ -359,13 +429,16 @@ void output_time_statistics(char input_file[], char output_file[]) {
             }
 
         }
-        avg = total_secs / counter; /**< Calculates the average total time in seconds */
-        /**Converts the average seconds to the time format of string type, and saves it in string avg_time.*/
-        avg_time = to_string(int(avg) / 3600) + ":" + to_string(int(avg) / 60) +
-            ":" + to_string(int(avg) % 60) + ":" + to_string(int(round(fmod(avg, 1) * 1000)));
-
-        /**The following line writes parsed strings to the output via o_d_stream object*/
-        o_d_stream << "max," << max_time << endl << "min," << min_time << endl << "avg," << avg_time << endl;
+        /** A run without any acknowledgement has no delay statistics */
+        if (counter > 0) {
+            avg = total_secs / counter; /**< Calculates the average total time in seconds */
+            /**Converts the average seconds to the time format of string type, and saves it in string avg_time.*/
+            avg_time = to_string(int(avg) / 3600) + ":" + to_string((int(avg) / 60) % 60) +
+                ":" + to_string(int(avg) % 60) + ":" + to_string(int(round(fmod(avg, 1) * 1000)));
+
+            /**The following line writes parsed strings to the output via o_d_stream object*/
+            o_d_stream << "max," << max_time << endl << "min," << min_time << endl << "avg," << avg_time << endl;
+        }
     }else{
         cout << "Files are not opened" << endl;
     }
@@ -374,4 +447,522 @@ void output_time_statistics(char input_file[], char output_file[]) {
     o_d_stream.close(); /**< Closes the output file */
 }
 
+/**
+ * The function which is taking the csv of output_file_evolution of a shared link run
+ * and writing the goodput of every flow and the fairness between them.
+ */
+void output_flow_statistics(char input_file[], char output_file[], long long horizon_ms) {
+
+    string payload;
+
+    /**
+     * Delivered packets (ackReceivedOut) and transmissions (dataOut) of every sender,
+     * indexed by the flow number taken from the component name.
+     */
+    map<int, long> delivered, transmissions;
 
+    ifstream i_d_stream(input_file); /**< Input data stream */
+    ofstream o_d_stream(output_file, ofstream::out | ofstream::trunc); /**< Output data stream */
+
+    if (!i_d_stream.is_open() || !o_d_stream.is_open()) {
+        cout << "Files are not opened" << endl;
+        return;
+    }
+    getline(i_d_stream, payload); /**< Header line, not used */
+
+    while (getline(i_d_stream, payload)) {
+        if (payload.length() == 0) {
+            continue;
+        }
+        /** The format is, 0-Time, 1-Value, 2-Port, and 3-Component. */
+        vector<string> payload_vec = split(payload, ',');
+        if (payload_vec.size() < 4) {
+            continue;
+        }
+        if (payload_vec[3].compare(0, 6, "sender") != 0) {
+            continue;
+        }
+        int flow = atoi(payload_vec[3].c_str() + 6);
+        if (payload_vec[2] == "ackReceivedOut") {
+            ++delivered[flow];
+        }else if (payload_vec[2] == "dataOut") {
+            ++transmissions[flow];
+        }
+    }
+
+    /**
+     * Goodput is in packets per hour of the simulated horizon, not of the time of the
+     * last message, so a flow going quiet early doesn't look faster. Jain's fairness
+     * index (sum x)^2 / (n * sum x^2) is 1 when all flows get the same goodput.
+     */
+    double hours = horizon_ms / 3600000.0;
+    double sum = 0, sum_squares = 0;
+    o_d_stream << "Flow,Delivered,Transmissions,Goodput" << endl;
+    for (const auto &flow : transmissions) {
+        double goodput = (hours > 0) ? delivered[flow.first] / hours : 0;
+        sum += goodput;
+        sum_squares += goodput * goodput;
+        o_d_stream << flow.first << "," << delivered[flow.first] << "," << flow.second << ","
+                   << goodput << endl;
+    }
+    double fairness = (sum_squares > 0) ? (sum * sum) / (transmissions.size() * sum_squares) : 0;
+    o_d_stream << "total," << sum << endl << "fairness," << fairness << endl;
+
+    i_d_stream.close(); /**< Closes the input file */
+    o_d_stream.close(); /**< Closes the output file */
+}
+
+/**
+ * Converts milliseconds to the HH:MM:SS:mmm format of the simulator.
+ */
+static string ms_to_time(long long ms) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%02lld:%02lld:%02lld:%03lld", ms / 3600000, (ms / 60000) % 60,
+             (ms / 1000) % 60, ms % 1000);
+    return buffer;
+}
+
+trace_timeline::trace_timeline(long long i_bucket_ms) : bucket_ms(i_bucket_ms > 0 ? i_bucket_ms : 60000) {}
+
+trace_timeline::bucket& trace_timeline::at(long long time_ms) {
+    size_t index = time_ms / bucket_ms;
+    if (index >= buckets.size()) {
+        buckets.resize(index + 1);
+    }
+    return buckets[index];
+}
+
+/**
+ * A dataOut repeating the value of the unacknowledged packet of its sender is a
+ * retransmission, any other starts a new packet. An ack closes the packet.
+ */
+void trace_timeline::add(const string &time, const string &value, const string &port, const string &component) {
+    long long time_ms = time_to_ms(time);
+    if (time_ms < 0) {
+        return;
+    }
+    if (port == "dataOut") {
+        bucket &b = at(time_ms);
+        ++b.transmissions;
+        int packet = stoi(value);
+        auto open = open_packets.find(component);
+        if (open != open_packets.end() && open->second.first == packet) {
+            ++b.retransmissions;
+        }else {
+            open_packets[component] = make_pair(packet, time_ms);
+        }
+    }else if (port == "ackReceivedOut") {
+        auto open = open_packets.find(component);
+        if (open == open_packets.end()) {
+            return;
+        }
+        bucket &b = at(time_ms);
+        long long delay_ms = time_ms - open->second.second;
+        ++b.acked;
+        b.total_delay_ms += delay_ms;
+        b.max_delay_ms = max(b.max_delay_ms, delay_ms);
+        open_packets.erase(open);
+    }
+}
+
+void trace_timeline::drop(const string &time, const string &component) {
+    long long time_ms = time_to_ms(time);
+    if (time_ms < 0) {
+        return;
+    }
+    if (component.compare(0, 7, "subnet1") == 0) {
+        ++at(time_ms).subnet1_drops;
+    }else if (component.compare(0, 7, "subnet2") == 0) {
+        ++at(time_ms).subnet2_drops;
+    }
+}
+
+void trace_timeline::write(ostream &o_d_stream) const {
+    double hours = bucket_ms / 3600000.0;
+    o_d_stream << "Start,End,Acked,Goodput,Transmissions,Retransmissions,MeanDelay,MaxDelay,"
+               << "Subnet1Drops,Subnet2Drops" << endl;
+    for (size_t i = 0; i < buckets.size(); i++) {
+        const bucket &b = buckets[i];
+        o_d_stream << ms_to_time(i * bucket_ms) << "," << ms_to_time((i + 1) * bucket_ms) << ","
+                   << b.acked << "," << b.acked / hours << "," << b.transmissions << ","
+                   << b.retransmissions << ",";
+        if (b.acked > 0) {
+            o_d_stream << ms_to_time((long long) llround((double) b.total_delay_ms / b.acked)) << ","
+                       << ms_to_time(b.max_delay_ms);
+        }else {
+            o_d_stream << ",";
+        }
+        o_d_stream << "," << b.subnet1_drops << "," << b.subnet2_drops << endl;
+    }
+}
+
+/**
+ * Stream version of output_delivery_report, following every packet of every sender
+ * from its first dataOut to its ackReceivedOut. The simulation service uses it on
+ * in-memory csv, with or without the row of every packet.
+ */
+void output_delivery_report(istream &i_d_stream, ostream &o_d_stream, bool packet_rows) {
+
+    /**
+     * Packet being followed, a packet starts with a dataOut whose value differs
+     * from the previous one or comes after an ack (a new burst of the generator
+     * may start again with the same value).
+     */
+    struct packet{
+        string component;
+        long number = 0;              /**< Packet count of the sender, from 1 */
+        int value = 0;                /**< dataOut value, packet number * 10 + alternating bit */
+        long long first_send_ms = 0;
+        long long final_ack_ms = -1;  /**< -1 while not delivered */
+        long transmissions = 0;
+    };
+
+    string payload;
+    long long last_time_ms = 0; /**< Time of the last message, duration of the run */
+    vector<packet> packets;
+    map<string, long> open_packet; /**< Index in packets of the unacknowledged packet of every sender */
+    map<string, long> sent;        /**< Packets sent by every sender */
+    long acks = 0;                 /**< Acknowledgements sent by the receivers, the reverse link traffic */
+    long naks = 0;                 /**< Negative ones among them */
+
+    getline(i_d_stream, payload); /**< Header line, not used */
+
+    while (getline(i_d_stream, payload)) {
+        if (payload.length() == 0) {
+            continue;
+        }
+        /** The format is, 0-Time, 1-Value, 2-Port, and 3-Component. */
+        vector<string> payload_vec = split(payload, ',');
+        if (payload_vec.size() < 4) {
+            continue;
+        }
+        long long time_ms = time_to_ms(payload_vec[0]);
+        if (time_ms < 0) {
+            continue;
+        }
+        last_time_ms = time_ms;
+        const string &component = payload_vec[3];
+        if (payload_vec[2] == "dataOut") {
+            int value = stoi(payload_vec[1]);
+            auto open = open_packet.find(component);
+            if (open != open_packet.end() && packets[open->second].value == value) {
+                ++packets[open->second].transmissions; /**< Retransmission after a timeout */
+                continue;
+            }
+            packet sent_packet;
+            sent_packet.component = component;
+            sent_packet.number = ++sent[component];
+            sent_packet.value = value;
+            sent_packet.first_send_ms = time_ms;
+            sent_packet.transmissions = 1;
+            open_packet[component] = packets.size();
+            packets.push_back(sent_packet);
+        }else if (payload_vec[2] == "ackReceivedOut") {
+            auto open = open_packet.find(component);
+            if (open != open_packet.end()) {
+                packets[open->second].final_ack_ms = time_ms;
+                open_packet.erase(open);
+            }
+        }else if (payload_vec[2] == "out" && component.compare(0, 8, "receiver") == 0) {
+            ++acks;
+            if (atoi(payload_vec[1].c_str()) >= message_nak_offset) {
+                ++naks;
+            }
+        }
+    }
+
+    /**
+     * The delay of a packet runs from its first transmission to its ack. The
+     * retransmission ratio is the share of transmissions which were retransmissions
+     * and the goodput is in delivered packets per hour of simulated time. The acks
+     * are the messages of the reverse link, the ack ratio compares them with the
+     * transmissions of the forward link.
+     */
+    long delivered = 0, transmissions = 0;
+    long long total_delay_ms = 0, max_delay_ms = 0, min_delay_ms = 0;
+    if (packet_rows) {
+        o_d_stream << "Component,Packet,Value,FirstSend,FinalAck,Transmissions,Delay" << endl;
+    }
+    for (const packet &p : packets) {
+        transmissions += p.transmissions;
+        if (packet_rows) {
+            o_d_stream << p.component << "," << p.number << "," << p.value << "," << ms_to_time(p.first_send_ms) << ",";
+            if (p.final_ack_ms < 0) {
+                o_d_stream << "," << p.transmissions << "," << endl;
+            }else {
+                o_d_stream << ms_to_time(p.final_ack_ms) << "," << p.transmissions << ","
+                           << ms_to_time(p.final_ack_ms - p.first_send_ms) << endl;
+            }
+        }
+        if (p.final_ack_ms < 0) {
+            continue;
+        }
+        long long delay_ms = p.final_ack_ms - p.first_send_ms;
+        if (delivered == 0 || delay_ms > max_delay_ms) {
+            max_delay_ms = delay_ms;
+        }
+        if (delivered == 0 || delay_ms < min_delay_ms) {
+            min_delay_ms = delay_ms;
+        }
+        ++delivered;
+        total_delay_ms += delay_ms;
+    }
+    long retransmissions = transmissions - packets.size();
+    double hours = last_time_ms / 3600000.0;
+    o_d_stream << "packets," << packets.size() << endl
+               << "delivered," << delivered << endl
+               << "transmissions," << transmissions << endl
+               << "retransmissions," << retransmissions << endl
+               << "retransmission_ratio," << (transmissions > 0 ? (double) retransmissions / transmissions : 0) << endl
+               << "acks," << acks << endl
+               << "ack_ratio," << (transmissions > 0 ? (double) acks / transmissions : 0) << endl
+               << "naks," << naks << endl
+               << "goodput," << (hours > 0 ? delivered / hours : 0) << endl;
+    if (delivered > 0) {
+        o_d_stream << "max," << ms_to_time(max_delay_ms) << endl
+                   << "min," << ms_to_time(min_delay_ms) << endl
+                   << "avg," << ms_to_time((long long) llround((double) total_delay_ms / delivered)) << endl;
+    }
+}
+
+/**
+ * The function which is taking the csv of output_file_evolution and writing
+ * the delivery report of every packet.
+ */
+void output_delivery_report(char input_file[], char output_file[]) {
+    struct stat stat_buff; /**< To get file statistics */
+    if (stat(input_file, &stat_buff) < 0) {
+        if (errno == ENOENT) {
+        cout << input_file << " doesn't exist: " << -ENOENT << endl;
+        }
+        return;
+    }
+
+    ifstream i_d_stream(input_file); /**< Input data stream */
+    ofstream o_d_stream(output_file, ofstream::out | ofstream::trunc); /**< Output data stream */
+
+    if (!i_d_stream.is_open() || !o_d_stream.is_open()) {
+        cout << "Files are not opened" << endl;
+        return;
+    }
+    output_delivery_report(i_d_stream, o_d_stream, true);
+
+    i_d_stream.close(); /**< Closes the input file */
+    o_d_stream.close(); /**< Closes the output file */
+}
+
+/**
+ * Replays the acceptance rule of the senders on the requests of the csv. The sender
+ * of generator_con_k is sender1_k. A request is started by the next dataOut of its
+ * sender and done by the ackReceivedOut of its last packet. The requests of a bag
+ * held by a sender are taken after its next dataOut or ackReceivedOut, a timeout
+ * in between doesn't change whether they are accepted since the sender is busy,
+ * and at once while the sender is idle. The controls which aren't requests (0 packets)
+ * keep their place in the bags.
+ */
+void output_request_report(istream &i_d_stream, ostream &o_d_stream, bool queued, bool request_rows,
+                           bag_policy bags) {
+
+    struct request{
+        string component;             /**< Sender of the request */
+        long number = 0;              /**< Request count of the sender, from 1 */
+        int packets = 0;
+        long long arrival_ms = 0;
+        long long first_send_ms = -1; /**< -1 while not started */
+        long long done_ms = -1;       /**< -1 while not done */
+        bool dropped = false;
+    };
+
+    /**
+     * Requests of a sender, the one being served and the queued ones
+     */
+    struct sender_requests{
+        long current = -1;            /**< Index in requests of the request served, -1 when idle */
+        int acked = 0;                /**< Packets of the request served acknowledged */
+        deque<long> waiting;
+        deque<long> held;             /**< Requests of bags not taken yet (bag_policy::queue), -1 for a control which isn't one */
+        long count = 0;
+    };
+
+    string payload;
+    long long last_time_ms = 0;
+    vector<request> requests;
+    map<string, sender_requests> senders;
+    vector<pair<string, long>> arrivals; /**< Senders and requests of the current time not yet accepted, -1 for a control which isn't one */
+    size_t max_queue = 0;
+
+    /**
+     * A request arriving when its sender acks its last packet is accepted, the sender
+     * is idle again at the end of that time (confluence transition), so the requests
+     * of a time are only accepted before the next dataOut or the next time.
+     */
+    auto accept = [&](long index) {
+        sender_requests &sender = senders[requests[index].component];
+        if (sender.current < 0) {
+            sender.current = index;
+            sender.acked = 0;
+        }else if (queued) {
+            sender.waiting.push_back(index);
+            max_queue = max(max_queue, sender.waiting.size());
+        }else {
+            requests[index].dropped = true;
+        }
+    };
+    /** The sender takes one held request after a transition, then more as long as it is idle */
+    auto take_held = [&](sender_requests &sender, bool after_transition) {
+        while (!sender.held.empty() && (after_transition || sender.current < 0)) {
+            after_transition = false;
+            long index = sender.held.front();
+            sender.held.pop_front();
+            if (index >= 0) {
+                accept(index);
+            }
+        }
+    };
+    auto accept_arrivals = [&]() {
+        map<string, size_t> bag_size;
+        for (const pair<string, long> &arrival : arrivals) {
+            bag_action action = bag_policy_action(bags, bag_size[arrival.first]++);
+            if (action == bag_action::hold) {
+                senders[arrival.first].held.push_back(arrival.second);
+            }else if (arrival.second >= 0) {
+                if (action == bag_action::take) {
+                    accept(arrival.second);
+                }else {
+                    requests[arrival.second].dropped = true;
+                }
+            }
+        }
+        for (auto &sender : bag_size) {
+            take_held(senders[sender.first], false);
+        }
+        arrivals.clear();
+    };
+
+    getline(i_d_stream, payload); /**< Header line, not used */
+
+    while (getline(i_d_stream, payload)) {
+        if (payload.length() == 0) {
+            continue;
+        }
+        /** The format is, 0-Time, 1-Value, 2-Port, and 3-Component. */
+        vector<string> payload_vec = split(payload, ',');
+        if (payload_vec.size() < 4) {
+            continue;
+        }
+        long long time_ms = time_to_ms(payload_vec[0]);
+        if (time_ms < 0) {
+            continue;
+        }
+        if (time_ms > last_time_ms) {
+            accept_arrivals();
+        }
+        last_time_ms = time_ms;
+        const string &component = payload_vec[3];
+        if (payload_vec[2] == "out" && component.compare(0, 13, "generator_con") == 0) {
+            int packets = atoi(payload_vec[1].c_str());
+            string sender = "sender1" + component.substr(13);
+            if (packets <= 0) {
+                arrivals.push_back(make_pair(sender, -1L));
+                continue;
+            }
+            request arrival;
+            arrival.component = sender;
+            arrival.number = ++senders[arrival.component].count;
+            arrival.packets = packets;
+            arrival.arrival_ms = time_ms;
+            arrivals.push_back(make_pair(sender, (long) requests.size()));
+            requests.push_back(arrival);
+        }else if (payload_vec[2] == "dataOut") {
+            accept_arrivals();
+            sender_requests &sender = senders[component];
+            if (sender.current >= 0 && requests[sender.current].first_send_ms < 0) {
+                requests[sender.current].first_send_ms = time_ms;
+            }
+            take_held(sender, true);
+        }else if (payload_vec[2] == "ackReceivedOut") {
+            sender_requests &sender = senders[component];
+            if (sender.current >= 0 && requests[sender.current].first_send_ms >= 0
+                && ++sender.acked >= requests[sender.current].packets) {
+                requests[sender.current].done_ms = time_ms;
+                sender.current = -1;
+                if (!sender.waiting.empty()) {
+                    sender.current = sender.waiting.front();
+                    sender.waiting.pop_front();
+                    sender.acked = 0;
+                }
+            }
+            take_held(sender, true);
+        }
+    }
+    accept_arrivals();
+
+    /**
+     * The wait of a request runs from its arrival to its first transmission, so it
+     * includes the preparation of its first packet. The packets per hour only count
+     * the packets of the done requests.
+     */
+    long served = 0, done = 0, dropped = 0, done_packets = 0;
+    long long total_wait_ms = 0, max_wait_ms = 0, total_completion_ms = 0;
+    if (request_rows) {
+        o_d_stream << "Component,Request,Packets,Arrival,FirstSend,Done,Wait,Completion,Status" << endl;
+    }
+    for (const request &r : requests) {
+        if (request_rows) {
+            o_d_stream << r.component << "," << r.number << "," << r.packets << "," << ms_to_time(r.arrival_ms) << ","
+                       << (r.first_send_ms < 0 ? "" : ms_to_time(r.first_send_ms)) << ","
+                       << (r.done_ms < 0 ? "" : ms_to_time(r.done_ms)) << ","
+                       << (r.first_send_ms < 0 ? "" : ms_to_time(r.first_send_ms - r.arrival_ms)) << ","
+                       << (r.done_ms < 0 ? "" : ms_to_time(r.done_ms - r.arrival_ms)) << ","
+                       << (r.dropped ? "dropped" : r.done_ms >= 0 ? "done" : r.first_send_ms >= 0 ? "started" : "waiting")
+                       << endl;
+        }
+        if (r.dropped) {
+            ++dropped;
+            continue;
+        }
+        if (r.first_send_ms < 0) {
+            continue;
+        }
+        long long wait_ms = r.first_send_ms - r.arrival_ms;
+        max_wait_ms = max(max_wait_ms, wait_ms);
+        total_wait_ms += wait_ms;
+        ++served;
+        if (r.done_ms >= 0) {
+            total_completion_ms += r.done_ms - r.arrival_ms;
+            done_packets += r.packets;
+            ++done;
+        }
+    }
+    double hours = last_time_ms / 3600000.0;
+    o_d_stream << "requests," << requests.size() << endl
+               << "served," << served << endl
+               << "done," << done << endl
+               << "dropped," << dropped << endl
+               << "max_queue," << max_queue << endl;
+    if (served > 0) {
+        o_d_stream << "wait_avg," << ms_to_time((long long) llround((double) total_wait_ms / served)) << endl
+                   << "wait_max," << ms_to_time(max_wait_ms) << endl;
+    }
+    if (done > 0) {
+        o_d_stream << "completion_avg," << ms_to_time((long long) llround((double) total_completion_ms / done)) << endl;
+    }
+    o_d_stream << "packets_per_hour," << (hours > 0 ? done_packets / hours : 0) << endl;
+}
+
+/**
+ * The function which is counting the messages of a csv of output_file_evolution,
+ * one row each below the header.
+ */
+long count_csv_events(char input_file[]) {
+    ifstream i_d_stream(input_file);
+    string line;
+    long rows = 0;
+    getline(i_d_stream, line); /**< Skips the header */
+    while (getline(i_d_stream, line)) {
+        if (line.length() > 0) {
+            ++rows;
+        }
+    }
+    return rows;
+}
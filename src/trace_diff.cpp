@@ -0,0 +1,123 @@
+/** \brief Streaming semantic diff of two simulator traces
+ *
+ * Both traces are read in lock step by simulation time with trace_reader, each may be
+ * a raw trace (abp_output.txt) or its csv form (file_mod_output.csv). The messages
+ * of one timestamp are compared as a set, so a different order of the bags within a
+ * timestamp is not a difference. The tool stops at the first semantic divergence and
+ * reports its time, component and port. Only one timestamp of each trace is held in
+ * memory.
+ *
+ * Usage: ./bin/TRACE_DIFF <left trace> <right trace>
+ * Exit status is 0 if the traces are equivalent, 1 if they diverge, 2 on error.
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "../include/trace_reader.hpp"
+
+using namespace std;
+
+/**
+ * @brief      Prints the divergence between two bags of the same or of different timestamps
+ *
+ * @param[in]  time   Time of the divergence
+ * @param[in]  only   Record which has no counterpart in the other trace
+ * @param[in]  side   Name of the trace the record belongs to
+ * @param[in]  other  Messages of the other trace on the same component and port
+ */
+static void report(const string &time, const trace_record &only, const char *side,
+                   const vector<trace_record> &other) {
+    cout << "First divergence at " << time << " component " << only.component
+         << " port " << only.port << endl;
+    cout << "  " << side << " has value " << only.value << endl;
+    cout << "  other trace has";
+    bool any = false;
+    for (const auto &r : other) {
+        if (r.component == only.component && r.port == only.port) {
+            cout << " " << r.value;
+            any = true;
+        }
+    }
+    cout << (any ? "" : " no message") << endl;
+}
+
+/**
+ * @brief      Compares two bags of the same timestamp as multisets
+ *
+ * @return     true if equal, otherwise the divergence is reported
+ */
+static bool compare_bags(const string &time, vector<trace_record> &left, vector<trace_record> &right) {
+    sort(left.begin(), left.end());
+    sort(right.begin(), right.end());
+    size_t l = 0, r = 0;
+    while (l < left.size() || r < right.size()) {
+        if (r == right.size() || (l < left.size() && left[l] < right[r])) {
+            report(time, left[l], "left", right);
+            return false;
+        }
+        if (l == left.size() || right[r] < left[l]) {
+            report(time, right[r], "right", left);
+            return false;
+        }
+        ++l;
+        ++r;
+    }
+    return true;
+}
+
+/**\brief  main function
+ *
+ * @param argc Integer argument - These are counting the command line arguments
+ * @param argv Argument vector - the two traces
+ */
+int main(int argc, char ** argv){
+
+    if (argc < 3) {
+        cout << "you are using this program with wrong parameters. The program should be invoked as follow:";
+        cout << argv[0] << " left_trace right_trace" << endl;
+        return 2;
+    }
+    ifstream left_stream(argv[1]);
+    ifstream right_stream(argv[2]);
+    if (!left_stream.is_open() || !right_stream.is_open()) {
+        cout << "Files are not opened" << endl;
+        return 2;
+    }
+
+    trace_reader left(left_stream), right(right_stream);
+    string left_time, right_time;
+    vector<trace_record> left_bag, right_bag;
+    bool has_left = left.next_bag(left_time, left_bag);
+    bool has_right = right.next_bag(right_time, right_bag);
+    long timestamps = 0, messages = 0;
+
+    while (has_left || has_right) {
+        /** A timestamp present in only one trace diverges at its first message */
+        if (!has_right || (has_left && left_bag[0].time_ms < right_bag[0].time_ms)) {
+            report(left_time, left_bag[0], "left", vector<trace_record>());
+            return 1;
+        }
+        if (!has_left || right_bag[0].time_ms < left_bag[0].time_ms) {
+            report(right_time, right_bag[0], "right", vector<trace_record>());
+            return 1;
+        }
+        if (!compare_bags(left_time, left_bag, right_bag)) {
+            return 1;
+        }
+        ++timestamps;
+        messages += left_bag.size();
+        has_left = left.next_bag(left_time, left_bag);
+        has_right = right.next_bag(right_time, right_bag);
+    }
+    cout << "Traces are equivalent: " << timestamps << " timestamps, " << messages << " messages" << endl;
+    return 0;
+}
@@ -0,0 +1,177 @@
+/** /brief This source file contains the capture filters of the trace logger.
+ *
+ * See trace_filter.hpp. The filter works on the lines written by the cadmium
+ * logger, a timestamp line (00:00:20:000) or a message line
+ * ([sender_defs::dataOut: {11}] generated by model sender1).
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include "../include/trace_filter.hpp"
+#include "../include/trace_reader.hpp"
+#include "../include/simulator_renaissance.hpp"
+
+using namespace std;
+
+/** Separator between the message bags and the name of the model in a trace line */
+static const string generated_by = " generated by model ";
+
+bool trace_filter::active() const {
+    return t0_ms > 0 || t1_ms >= 0 || !include_models.empty() ||
+           !exclude_models.empty() || !ports.empty();
+}
+
+bool trace_filter::accepts_time(long long ms) const {
+    return ms >= t0_ms && (t1_ms < 0 || ms <= t1_ms);
+}
+
+bool trace_filter::accepts_model(const string &model) const {
+    if (!include_models.empty() &&
+        find(include_models.begin(), include_models.end(), model) == include_models.end()) {
+        return false;
+    }
+    return find(exclude_models.begin(), exclude_models.end(), model) == exclude_models.end();
+}
+
+bool trace_filter::accepts_port(const string &port) const {
+    return ports.empty() || find(ports.begin(), ports.end(), port) != ports.end();
+}
+
+bool parse_trace_filter_option(int argc, char ** argv, int &i, trace_filter &filter) {
+    string option = argv[i];
+    if (option == "--window" && i + 2 < argc) {
+        filter.t0_ms = parse_time_ms(argv[i + 1]);
+        filter.t1_ms = parse_time_ms(argv[i + 2]);
+        i += 2;
+        return filter.t0_ms >= 0 && filter.t1_ms >= 0;
+    }
+    if (i + 1 >= argc) {
+        return false;
+    }
+    vector<string> *list = nullptr;
+    if (option == "--models") {
+        list = &filter.include_models;
+    }else if (option == "--exclude-models") {
+        list = &filter.exclude_models;
+    }else if (option == "--ports") {
+        list = &filter.ports;
+    }else {
+        return false;
+    }
+    for (const string &item : split(argv[++i], ',')) {
+        if (!item.empty()) {
+            list->push_back(item);
+        }
+    }
+    return true;
+}
+
+trace_filter_buf::trace_filter_buf(ostream &o_stream, const trace_filter &i_filter)
+    : o_d_stream(o_stream), filter(i_filter) {}
+
+int trace_filter_buf::overflow(int c) {
+    if (c == traits_type::eof()) {
+        return traits_type::not_eof(c);
+    }
+    if (c == '\n') {
+        process_line();
+    }else {
+        line.push_back(static_cast<char>(c));
+    }
+    return c;
+}
+
+/**
+ * Appends the text up to each newline to the line in one block, instead of one
+ * overflow per character
+ */
+streamsize trace_filter_buf::xsputn(const char *s, streamsize n) {
+    const char *end = s + n;
+    while (s < end) {
+        const char *newline = static_cast<const char *>(memchr(s, '\n', end - s));
+        line.append(s, (newline != nullptr ? newline : end) - s);
+        if (newline == nullptr) {
+            break;
+        }
+        process_line();
+        s = newline + 1;
+    }
+    return n;
+}
+
+int trace_filter_buf::sync() {
+    o_d_stream.flush();
+    return 0;
+}
+
+/**
+ * Keeps the bags of the ports accepted by the filter which have messages
+ *
+ * @return     The rewritten line, empty if no message is left
+ */
+string trace_filter_buf::filter_ports(const string &i_line, size_t model_pos) {
+    size_t bag_end = i_line.rfind(']', model_pos);
+    string kept;
+    size_t pos = 1;
+    while (pos < bag_end) {
+        size_t open = i_line.find(": {", pos);
+        if (open == string::npos || open > bag_end) {
+            break;
+        }
+        size_t close = i_line.find('}', open);
+        string port = i_line.substr(pos, open - pos);
+        size_t scope = port.rfind("::");
+        string port_name = (scope == string::npos) ? port : port.substr(scope + 2);
+        if (close > open + 3 && filter.accepts_port(port_name)) {
+            kept += (kept.empty() ? "" : ", ") + i_line.substr(pos, close + 1 - pos);
+        }
+        pos = close + 1;
+        while (pos < bag_end && (i_line[pos] == ',' || i_line[pos] == ' ')) {
+            ++pos;
+        }
+    }
+    if (kept.empty()) {
+        return kept;
+    }
+    return "[" + kept + "]" + i_line.substr(model_pos);
+}
+
+void trace_filter_buf::process_line() {
+    if (!line.empty() && line[0] != '[') {
+        long long ms = parse_time_ms(line);
+        if (ms >= 0) {
+            time = line;
+            time_ms = ms;
+            time_written = false;
+        }
+    }else if (!line.empty() && filter.accepts_time(time_ms)) {
+        size_t model_pos = line.rfind(generated_by);
+        if (model_pos != string::npos &&
+            filter.accepts_model(line.substr(model_pos + generated_by.size()))) {
+            string kept = filter_ports(line, model_pos);
+            if (!kept.empty()) {
+                if (!time_written) {
+                    o_d_stream << time << '\n';
+                    time_written = true;
+                }
+                o_d_stream << kept << '\n';
+            }
+        }
+    }
+    line.clear();
+}
+
+trace_filter_stream::trace_filter_stream(ostream &o_stream, const trace_filter &filter)
+    : ostream(nullptr), buf(o_stream, filter) {
+    rdbuf(&buf);
+}
@@ -0,0 +1,143 @@
+/** /brief This source file contains the sparse time index of the simulator traces.
+ *
+ * A line of a raw trace is either a timestamp (HH:MM:SS:mmm) or a message line
+ * starting with '['. trace_index_buf only keeps the characters of the lines which
+ * aren't message lines, so indexing costs one test per byte of the trace.
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../include/trace_index.hpp"
+#include "../include/trace_reader.hpp"
+
+using namespace std;
+
+trace_index_buf::trace_index_buf(ostream *trace, ostream &index, long i_every)
+    : o_trace(trace), o_index(index), every(i_every > 0 ? i_every : 1) {
+    o_index << "Time,Offset" << '\n';
+}
+
+void trace_index_buf::scan(char c) {
+    if (c == '\n') {
+        if (!bag_line) {
+            long long ms = parse_time_ms(line);
+            if (ms >= 0 && timestamps++ % every == 0) {
+                o_index << format_time_ms(ms) << ',' << line_offset << '\n';
+            }
+        }
+        line.clear();
+        bag_line = false;
+        line_offset = offset + 1;
+    }else if (offset == line_offset && c == '[') {
+        bag_line = true;
+    }else if (!bag_line) {
+        line.push_back(c);
+    }
+    offset++;
+}
+
+int trace_index_buf::overflow(int c) {
+    if (c == traits_type::eof()) {
+        return traits_type::not_eof(c);
+    }
+    if (o_trace != nullptr) {
+        o_trace->put(static_cast<char>(c));
+    }
+    scan(static_cast<char>(c));
+    return c;
+}
+
+streamsize trace_index_buf::xsputn(const char *s, streamsize n) {
+    if (o_trace != nullptr) {
+        o_trace->write(s, n);
+    }
+    for (streamsize i = 0; i < n; i++) {
+        scan(s[i]);
+    }
+    return n;
+}
+
+long long trace_index_buf::timestamp_count() const {
+    return timestamps;
+}
+
+int trace_index_buf::sync() {
+    if (o_trace != nullptr) {
+        o_trace->flush();
+    }
+    o_index.flush();
+    return 0;
+}
+
+trace_index_stream::trace_index_stream(ostream &trace, ostream &index, long every)
+    : ostream(nullptr), buf(&trace, index, every) {
+    rdbuf(&buf);
+}
+
+long long build_trace_index(istream &i_trace, ostream &o_index, long every) {
+    trace_index_buf buf(nullptr, o_index, every);
+    char block[65536];
+    while (i_trace.read(block, sizeof(block)) || i_trace.gcount() > 0) {
+        buf.sputn(block, i_trace.gcount());
+    }
+    buf.pubsync();
+    return buf.timestamp_count();
+}
+
+vector<trace_index_entry> read_trace_index(istream &i_index) {
+    vector<trace_index_entry> entries;
+    string line;
+    while (getline(i_index, line)) {
+        size_t comma = line.find(',');
+        if (comma == string::npos) {
+            continue;
+        }
+        long long ms = parse_time_ms(line.substr(0, comma));
+        if (ms < 0) {
+            continue;
+        }
+        entries.push_back(trace_index_entry{ms, stoll(line.substr(comma + 1))});
+    }
+    return entries;
+}
+
+long long trace_index_seek(const vector<trace_index_entry> &entries, long long time_ms) {
+    size_t low = 0, high = entries.size();
+    /** First entry at or after the time, the one before it is the last one before the time */
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (entries[middle].time_ms < time_ms) {
+            low = middle + 1;
+        }else {
+            high = middle;
+        }
+    }
+    return (low == 0) ? 0 : entries[low - 1].offset;
+}
+
+long long slice_trace(istream &i_trace, long long offset, const trace_filter &filter, ostream &o_slice) {
+    i_trace.clear();
+    i_trace.seekg(offset);
+    trace_filter_stream filtered(o_slice, filter);
+    string line;
+    long long bytes = 0;
+    while (getline(i_trace, line)) {
+        bytes += line.size() + 1;
+        if (!line.empty() && line[0] != '[') {
+            long long ms = parse_time_ms(line);
+            if (filter.t1_ms >= 0 && ms > filter.t1_ms) {
+                break;
+            }
+        }
+        filtered << line << '\n';
+    }
+    filtered.flush();
+    return bytes;
+}
@@ -0,0 +1,217 @@
+/** /brief This source file contains the streaming reader for simulator traces.
+ *
+ * The raw trace of the cadmium logger alternates timestamp lines and one line per
+ * model of the step:
+ *
+ * 00:00:20:000
+ * [] generated by model generator_con
+ * [sender_defs::packetSentOut: {1}, sender_defs::ackReceivedOut: {}, sender_defs::dataOut: {11}] generated by model sender1
+ *
+ * The csv of output_file_evolution has one message per line after its header.
+ * Both are turned into trace_record, see trace_reader.hpp.
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <tuple>
+#include <cstdio>
+
+#include "../include/trace_reader.hpp"
+
+using namespace std;
+
+/** Separator between the message bags and the name of the model in a raw trace line */
+static const string generated_by = " generated by model ";
+
+bool operator<(const trace_record &a, const trace_record &b) {
+    return tie(a.component, a.port, a.value) < tie(b.component, b.port, b.value);
+}
+
+bool operator==(const trace_record &a, const trace_record &b) {
+    return a.component == b.component && a.port == b.port && a.value == b.value;
+}
+
+/**
+ * The fields are accumulated digit by digit, which accepts hours of any width
+ * (NDTime prints more than two digits after 99 hours).
+ */
+long long parse_time_ms(const string &s) {
+    long long fields[4] = {0, 0, 0, 0};
+    int field = 0;
+    bool digit_seen = false;
+    for (char c : s) {
+        if (c >= '0' && c <= '9') {
+            fields[field] = fields[field] * 10 + (c - '0');
+            digit_seen = true;
+        }else if (c == ':' && digit_seen && field < 3) {
+            ++field;
+            digit_seen = false;
+        }else if (c == '\r') {
+            break;
+        }else {
+            return -1;
+        }
+    }
+    if (field < 2 || !digit_seen) {
+        return -1;
+    }
+    return ((fields[0] * 60 + fields[1]) * 60 + fields[2]) * 1000 + fields[3];
+}
+
+string format_time_ms(long long ms) {
+    char buff[32];
+    snprintf(buff, sizeof(buff), "%02lld:%02lld:%02lld:%03lld", ms / 3600000, (ms / 60000) % 60,
+             (ms / 1000) % 60, ms % 1000);
+    return buff;
+}
+
+trace_reader::trace_reader(istream &i_stream) : i_d_stream(i_stream) {}
+
+bool trace_reader::is_csv() const {
+    return csv;
+}
+
+/**
+ * Parses "[a_defs::p1: {v1, v2}, a_defs::p2: {}] generated by model name"
+ * into one record per message.
+ */
+void trace_reader::parse_raw_line(const string &line) {
+    size_t model_pos = line.rfind(generated_by);
+    if (model_pos == string::npos || line[0] != '[') {
+        return;
+    }
+    string component = line.substr(model_pos + generated_by.size());
+    if (!component.empty() && component.back() == '\r') {
+        component.pop_back();
+    }
+    size_t bag_end = line.rfind(']', model_pos);
+    size_t pos = 1;
+    while (pos < bag_end) {
+        size_t open = line.find(": {", pos);
+        if (open == string::npos || open > bag_end) {
+            break;
+        }
+        size_t close = line.find('}', open);
+        string port = line.substr(pos, open - pos);
+        size_t scope = port.rfind("::");
+        if (scope != string::npos) {
+            port = port.substr(scope + 2);
+        }
+        /** Messages of one port are separated by ", " */
+        size_t value_pos = open + 3;
+        while (value_pos < close) {
+            size_t comma = line.find(", ", value_pos);
+            if (comma == string::npos || comma > close) {
+                comma = close;
+            }
+            trace_record record;
+            record.time = time;
+            record.time_ms = time_ms;
+            record.value = line.substr(value_pos, comma - value_pos);
+            record.port = port;
+            record.component = component;
+            pending.push_back(record);
+            value_pos = comma + 2;
+        }
+        pos = close + 1;
+        while (pos < bag_end && (line[pos] == ',' || line[pos] == ' ')) {
+            ++pos;
+        }
+    }
+}
+
+/**
+ * Parses "Time,Value,Port,Component"
+ */
+void trace_reader::parse_csv_line(const string &line) {
+    size_t first = line.find(',');
+    size_t second = (first == string::npos) ? first : line.find(',', first + 1);
+    size_t third = (second == string::npos) ? second : line.find(',', second + 1);
+    if (third == string::npos) {
+        return;
+    }
+    trace_record record;
+    record.time = line.substr(0, first);
+    record.time_ms = parse_time_ms(record.time);
+    record.value = line.substr(first + 1, second - first - 1);
+    record.port = line.substr(second + 1, third - second - 1);
+    record.component = line.substr(third + 1);
+    if (!record.component.empty() && record.component.back() == '\r') {
+        record.component.pop_back();
+    }
+    pending.push_back(record);
+}
+
+/**
+ * Reads lines until at least one record is pending
+ */
+bool trace_reader::read_line_records() {
+    string line;
+    pending.clear();
+    pending_pos = 0;
+    while (pending.empty() && getline(i_d_stream, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        if (!format_known) {
+            format_known = true;
+            if (line.compare(0, 25, "Time,Value,Port,Component") == 0) {
+                csv = true;
+                continue;
+            }
+        }
+        if (csv) {
+            parse_csv_line(line);
+        }else if (line[0] != '[') {
+            long long ms = parse_time_ms(line);
+            if (ms >= 0) {
+                time = line;
+                if (time.back() == '\r') {
+                    time.pop_back();
+                }
+                time_ms = ms;
+            }
+        }else if (line.compare(0, 3, "[] ") != 0) {
+            parse_raw_line(line);
+        }
+    }
+    return !pending.empty();
+}
+
+bool trace_reader::next_record(trace_record &record) {
+    if (has_lookahead) {
+        record = lookahead;
+        has_lookahead = false;
+        return true;
+    }
+    if (pending_pos >= pending.size() && !read_line_records()) {
+        return false;
+    }
+    record = pending[pending_pos++];
+    return true;
+}
+
+bool trace_reader::next_bag(string &bag_time, vector<trace_record> &records) {
+    records.clear();
+    trace_record record;
+    if (!next_record(record)) {
+        return false;
+    }
+    bag_time = record.time;
+    records.push_back(record);
+    while (next_record(record)) {
+        if (record.time_ms != records[0].time_ms) {
+            lookahead = record;
+            has_lookahead = true;
+            break;
+        }
+        records.push_back(record);
+    }
+    return true;
+}
@@ -0,0 +1,136 @@
+/** \brief Time range queries on a large raw trace through its sparse index
+ *
+ * TRACE_SLICE seeks straight to a time window of a raw trace (abp_output.txt) with the
+ * index of trace_index.hpp and converts only that slice to the csv of
+ * output_file_evolution, optionally restricted to some models and ports with the
+ * capture options of the simulator. The index is read from <trace>.idx, it is built
+ * first if it is missing or older than the trace. --build only (re)builds the index.
+ *
+ * Usage: ./bin/TRACE_SLICE <raw trace> --window t0 t1 [--models a,b] [--exclude-models a,b]
+ *                          [--ports p,q] [--raw] [--every N] [--index file] [output file]
+ *        ./bin/TRACE_SLICE <raw trace> --build [--every N] [--index file]
+ * The csv (or the raw slice with --raw) is written to the output file, or to the
+ * standard output.
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <sys/stat.h>
+
+#include "../include/trace_index.hpp"
+#include "../include/trace_filter.hpp"
+#include "../include/trace_reader.hpp"
+#include "../include/simulator_renaissance.hpp"
+
+using namespace std;
+
+using hclock=chrono::high_resolution_clock;
+
+/**
+ * @brief      Modification time of a file, -1 if it doesn't exist
+ */
+static long long modification_time(const string &path) {
+    struct stat stat_buff;
+    if (stat(path.c_str(), &stat_buff) != 0) {
+        return -1;
+    }
+    return (long long) stat_buff.st_mtim.tv_sec * 1000000000LL + stat_buff.st_mtim.tv_nsec;
+}
+
+/**\brief  main function
+ *
+ * @param argc Integer argument - These are counting the command line arguments
+ * @param argv Argument vector - trace, window, filters and output file
+ */
+int main(int argc, char ** argv){
+
+    trace_filter filter;
+    bool raw = false;
+    bool build_only = false;
+    long every = trace_index_default_every;
+    string index_path;
+    vector<string> args;
+    for (int i = 1; i < argc; i++) {
+        string option = argv[i];
+        if (option == "--raw") {
+            raw = true;
+        }else if (option == "--build") {
+            build_only = true;
+        }else if (option == "--every" && i + 1 < argc) {
+            every = atol(argv[++i]);
+        }else if (option == "--index" && i + 1 < argc) {
+            index_path = argv[++i];
+        }else if (option.compare(0, 2, "--") == 0) {
+            if (!parse_trace_filter_option(argc, argv, i, filter)) {
+                cout << "invalid option " << option << endl;
+                return 1;
+            }
+        }else {
+            args.push_back(option);
+        }
+    }
+    if (args.empty() || every <= 0 || (!build_only && filter.t1_ms < 0)) {
+        cout << "you are using this program with wrong parameters. The program should be invoked as follow:";
+        cout << argv[0] << " raw trace --window t0 t1 [--models a,b] [--exclude-models a,b] [--ports p,q]"
+             << " [--raw] [--every N] [--index file] [output file]" << endl;
+        cout << "or " << argv[0] << " raw trace --build [--every N] [--index file]" << endl;
+        return 1;
+    }
+    string trace_path = args[0];
+    if (index_path.empty()) {
+        index_path = trace_path + ".idx";
+    }
+    ifstream trace(trace_path, ios::binary);
+    if (!trace) {
+        cout << "can't read " << trace_path << endl;
+        return 1;
+    }
+
+    /** The index is built when asked, missing or older than the trace */
+    long long trace_time = modification_time(trace_path);
+    long long index_time = modification_time(index_path);
+    if (build_only || index_time < 0 || index_time < trace_time) {
+        auto start = hclock::now();
+        ofstream index_out(index_path, ofstream::out | ofstream::trunc);
+        long long timestamps = build_trace_index(trace, index_out, every);
+        double secs = chrono::duration_cast<chrono::duration<double, ratio<1>>>(hclock::now() - start).count();
+        cerr << "indexed " << timestamps << " timestamps of " << trace_path << " into " << index_path
+             << " in " << secs << "sec" << endl;
+        if (build_only) {
+            return 0;
+        }
+    }
+    ifstream index_in(index_path);
+    vector<trace_index_entry> entries = read_trace_index(index_in);
+
+    auto start = hclock::now();
+    long long offset = trace_index_seek(entries, filter.t0_ms);
+    ostringstream slice;
+    long long bytes = slice_trace(trace, offset, filter, slice);
+
+    ofstream output_file;
+    if (args.size() > 1) {
+        output_file.open(args[1], ofstream::out | ofstream::trunc);
+    }
+    ostream &output = output_file.is_open() ? output_file : cout;
+    if (raw) {
+        output << slice.str();
+    }else {
+        istringstream slice_stream(slice.str());
+        output_file_evolution(slice_stream, output);
+    }
+    output.flush();
+    double secs = chrono::duration_cast<chrono::duration<double, ratio<1>>>(hclock::now() - start).count();
+    cerr << "read " << bytes << " bytes from offset " << offset << " in " << secs << "sec" << endl;
+    return 0;
+}
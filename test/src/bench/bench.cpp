@@ -0,0 +1,308 @@
+/** \brief End-to-end performance regression suite for the ABP simulator
+ *
+ * The suite generates scaled control inputs, runs bin/ABP_RELEASE (the simulator built
+ * optimized by make bench) on each of them in a child process, then runs
+ * output_file_evolution and output_time_statistics on the produced trace. For every
+ * scale it records:
+ *      - events/sec  (message events written to the trace per second of the simulation
+ *                     phase of the child, read from its run_metrics.csv, so the parsing
+ *                     and reports of the child aren't counted)
+ *      - MB/s parsed (trace megabytes converted to csv per second by each post-processing function)
+ *      - peak RSS    (maximum resident set size of the simulator process in kB)
+ *
+ * Results are written to data/bench/bench_results.csv and compared with the stored
+ * baseline file. A metric that is worse than the baseline by more than the threshold
+ * (in percent) is flagged as a regression and the suite exits with status 1. It also
+ * fails when there is no baseline to compare with.
+ *
+ * Usage: ./bin/ABP_BENCH [baseline file] [threshold percent] [update]
+ * Passing "update" as third argument stores the current results as the new baseline.
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include "../../../include/simulator_renaissance.hpp"
+
+using namespace std;
+
+using hclock=chrono::high_resolution_clock;
+
+/**Directory holding the generated inputs and the outputs of every scale*/
+char bench_directory[] = "./data/bench";
+/**Default baseline file*/
+char baseline_file[] = "./data/bench/baseline.csv";
+/**File the results of the current run are written to*/
+char results_file[] = "./data/bench/bench_results.csv";
+/**Simulator binary under benchmark*/
+char simulator_binary[] = "./bin/ABP_RELEASE";
+
+/**
+ * Number of packets requested by the generated control input of each scale.
+ * The first scale matches data/input_abp_0.txt and input_abp_1.txt in size.
+ */
+const int bench_scales[] = {5, 100, 1000, 5000};
+
+/**
+ * Structure holding the measured metrics of a single scale
+ */
+struct bench_result{
+    int scale;
+    long events;                /**< Message events in the trace */
+    double sim_secs;            /**< Simulation phase of the simulator process */
+    double events_per_sec;
+    double evolution_mb_per_sec;  /**< Throughput of output_file_evolution */
+    double statistics_mb_per_sec; /**< Throughput of output_time_statistics */
+    long peak_rss_kb;
+};
+
+/**
+ * @brief      Returns the size of a file in bytes, 0 if it doesn't exist
+ */
+static long file_size(const string &path) {
+    struct stat stat_buff;
+    if (stat(path.c_str(), &stat_buff) < 0) {
+        return 0;
+    }
+    return stat_buff.st_size;
+}
+
+/**
+ * @brief      Formats a number of seconds as HH:MM:SS for the control input and end time
+ */
+static string format_time(long secs) {
+    char buff[32];
+    snprintf(buff, sizeof(buff), "%02ld:%02ld:%02ld", secs / 3600, (secs / 60) % 60, secs % 60);
+    return buff;
+}
+
+/**
+ * @brief      Writes a control input requesting scale packets at 00:00:10
+ *
+ * @return     Simulation end time long enough for the transfer to complete
+ */
+static string generate_input(const string &path, int scale) {
+    ofstream o_d_stream(path, ofstream::out | ofstream::trunc);
+    o_d_stream << "00:00:10 " << scale << endl;
+    /** A packet needs 26 secs without losses, 45 secs leaves room for retransmissions */
+    return format_time(60 + 45L * scale);
+}
+
+/**
+ * @brief      Duration of the last simulation phase of a run metrics file
+ * @return     Seconds, -1 if the file has no simulation phase
+ */
+static double simulation_secs(const string &path) {
+    ifstream i_d_stream(path);
+    string line;
+    double secs = -1;
+    while (getline(i_d_stream, line)) {
+        vector<string> fields = split(line, ',');
+        if (fields.size() > 2 && fields[1] == "simulation") {
+            secs = stod(fields[2]);
+        }
+    }
+    return secs;
+}
+
+/**
+ * @brief      Runs the simulator in a child process
+ *
+ * The standard output of the child is discarded. The duration of the simulation is
+ * the simulation phase the child writes to the run metrics file of its output
+ * directory. The peak RSS is taken from the resource usage of the child reported
+ * by wait4.
+ *
+ * @return     true if the simulator exited with status 0 and wrote its simulation phase
+ */
+static bool run_simulator(const string &input, const string &end_time,
+                          const string &output_dir, double &secs, long &peak_rss_kb) {
+    /** The child appends to the run metrics file, the one of an earlier run is removed */
+    string run_metrics = output_dir + "/run_metrics.csv";
+    unlink(run_metrics.c_str());
+    pid_t pid = fork();
+    if (pid < 0) {
+        return false;
+    }
+    if (pid == 0) {
+        int dev_null = open("/dev/null", O_WRONLY);
+        dup2(dev_null, STDOUT_FILENO);
+        execl(simulator_binary, simulator_binary, input.c_str(), end_time.c_str(),
+              output_dir.c_str(), (char *) NULL);
+        _exit(127);
+    }
+    int status = 0;
+    struct rusage usage;
+    wait4(pid, &status, 0, &usage);
+    secs = simulation_secs(run_metrics);
+    peak_rss_kb = usage.ru_maxrss;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 && secs > 0;
+}
+
+/**
+ * @brief      Runs one scale end to end and fills the result
+ */
+static bool run_scale(int scale, bench_result &result) {
+    string scale_dir = string(bench_directory) + "/scale_" + to_string(scale);
+    mkdir(scale_dir.c_str(), 0755);
+    string input = scale_dir + "/input_abp.txt";
+    string trace = scale_dir + "/abp_output.txt";
+    string mod_output = scale_dir + "/file_mod_output.csv";
+    string time_stats = scale_dir + "/time_stats_output.csv";
+
+    string end_time = generate_input(input, scale);
+    result.scale = scale;
+    if (!run_simulator(input, end_time, scale_dir, result.sim_secs, result.peak_rss_kb)) {
+        cout << simulator_binary << " failed on " << input << endl;
+        return false;
+    }
+
+    /** The simulator already post-processed its trace, time our own pass over it */
+    double trace_mb = file_size(trace) / (1024.0 * 1024.0);
+    auto start = hclock::now();
+    output_file_evolution(&trace[0], &mod_output[0]);
+    double evolution_secs = chrono::duration_cast<chrono::duration<double,
+                            ratio<1>>>(hclock::now() - start).count();
+
+    double csv_mb = file_size(mod_output) / (1024.0 * 1024.0);
+    start = hclock::now();
+    output_time_statistics(&mod_output[0], &time_stats[0]);
+    double statistics_secs = chrono::duration_cast<chrono::duration<double,
+                             ratio<1>>>(hclock::now() - start).count();
+
+    result.events = count_csv_events(&mod_output[0]);
+    result.events_per_sec = result.events / result.sim_secs;
+    result.evolution_mb_per_sec = trace_mb / evolution_secs;
+    result.statistics_mb_per_sec = csv_mb / statistics_secs;
+    return true;
+}
+
+/**
+ * @brief      Writes results in csv format
+ */
+static void write_results(const string &path, const vector<bench_result> &results) {
+    ofstream o_d_stream(path, ofstream::out | ofstream::trunc);
+    o_d_stream << "Scale,Events,SimSecs,EventsPerSec,EvolutionMBPerSec,StatisticsMBPerSec,PeakRSSkB" << endl;
+    for (const auto &r : results) {
+        o_d_stream << r.scale << "," << r.events << "," << r.sim_secs << "," << r.events_per_sec << ","
+                   << r.evolution_mb_per_sec << "," << r.statistics_mb_per_sec << ","
+                   << r.peak_rss_kb << endl;
+    }
+}
+
+/**
+ * @brief      Reads a results file written by write_results, indexed by scale
+ */
+static map<int, bench_result> read_results(const string &path) {
+    map<int, bench_result> results;
+    ifstream i_d_stream(path);
+    string line;
+    getline(i_d_stream, line);
+    while (getline(i_d_stream, line)) {
+        if (line.length() == 0) {
+            continue;
+        }
+        vector<string> fields = split(line, ',');
+        if (fields.size() < 7) {
+            continue;
+        }
+        bench_result r;
+        r.scale = stoi(fields[0]);
+        r.events = stol(fields[1]);
+        r.sim_secs = stod(fields[2]);
+        r.events_per_sec = stod(fields[3]);
+        r.evolution_mb_per_sec = stod(fields[4]);
+        r.statistics_mb_per_sec = stod(fields[5]);
+        r.peak_rss_kb = stol(fields[6]);
+        results[r.scale] = r;
+    }
+    return results;
+}
+
+/**
+ * @brief      Compares one metric with the baseline and prints the verdict
+ *
+ * @param[in]  higher_is_better  true for throughputs, false for memory
+ * @return     true if the metric regressed by more than threshold percent
+ */
+static bool check_metric(int scale, const char *name, double current, double baseline,
+                         bool higher_is_better, double threshold) {
+    double change = (baseline != 0) ? (current - baseline) / baseline * 100.0 : 0;
+    bool regressed = higher_is_better ? (change < -threshold) : (change > threshold);
+    cout << "scale " << scale << " " << name << ": " << current << " (baseline " << baseline
+         << ", " << (change >= 0 ? "+" : "") << change << "%)" << (regressed ? "  REGRESSION" : "") << endl;
+    return regressed;
+}
+
+/**\brief  main function
+ *
+ * @param argc Integer argument - These are counting the command line arguments
+ * @param argv Argument vector - baseline file, threshold in percent and "update"
+ */
+int main(int argc, char ** argv){
+
+    string baseline = (argc > 1) ? argv[1] : baseline_file;
+    double threshold = (argc > 2) ? atof(argv[2]) : 10.0;
+    bool update = (argc > 3) && string(argv[3]) == "update";
+
+    mkdir(bench_directory, 0755);
+
+    vector<bench_result> results;
+    for (int scale : bench_scales) {
+        bench_result result;
+        if (!run_scale(scale, result)) {
+            return 1;
+        }
+        cout << "scale " << scale << ": " << result.events << " events in " << result.sim_secs
+             << "sec" << endl;
+        results.push_back(result);
+    }
+    write_results(results_file, results);
+
+    if (update) {
+        write_results(baseline, results);
+        cout << "Baseline stored in " << baseline << endl;
+        return 0;
+    }
+    if (file_size(baseline) == 0) {
+        cout << "No baseline in " << baseline << " to compare with, store one with make bench_baseline" << endl;
+        return 1;
+    }
+
+    map<int, bench_result> baseline_results = read_results(baseline);
+    bool regressed = false;
+    for (const auto &r : results) {
+        auto b = baseline_results.find(r.scale);
+        if (b == baseline_results.end()) {
+            cout << "scale " << r.scale << ": not in baseline" << endl;
+            continue;
+        }
+        regressed |= check_metric(r.scale, "events/sec", r.events_per_sec,
+                                  b->second.events_per_sec, true, threshold);
+        regressed |= check_metric(r.scale, "evolution MB/s", r.evolution_mb_per_sec,
+                                  b->second.evolution_mb_per_sec, true, threshold);
+        regressed |= check_metric(r.scale, "statistics MB/s", r.statistics_mb_per_sec,
+                                  b->second.statistics_mb_per_sec, true, threshold);
+        regressed |= check_metric(r.scale, "peak RSS kB", r.peak_rss_kb,
+                                  b->second.peak_rss_kb, false, threshold);
+    }
+    cout << (regressed ? "Performance regression detected" : "No performance regression") << endl;
+    return regressed ? 1 : 0;
+}
@@ -0,0 +1,139 @@
+/** \brief Stand-in client of the simulation service
+ *
+ * Connects to ABP_SERVER (src/abp_server.cpp), submits the same scenario as many
+ * jobs on one connection, reads the answers and prints the jobs per second. The
+ * answers are printed unless --quiet is given. With --shutdown the server is asked
+ * to stop once it has answered the jobs. The client fails if a job answers ERROR
+ * or if an answer is missing. With --expect-error it fails unless every job answers
+ * ERROR, to check that the server rejects malformed jobs.
+ *
+ * Usage: ./bin/ABP_CLIENT <socket path> <control input> [horizon] [jobs] [job parameters, e.g. timeline=00:10:00:000]
+ *                         [--quiet] [--shutdown] [--expect-error]
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+using hclock=chrono::high_resolution_clock;
+
+/**
+ * @brief      Writes the whole request
+ */
+static bool send_all(int fd, const string &request) {
+    size_t sent = 0;
+    while (sent < request.size()) {
+        ssize_t n = ::send(fd, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        sent += n;
+    }
+    return true;
+}
+
+/**\brief  main function
+ *
+ * @param argc Integer argument - These are counting the command line arguments
+ * @param argv Argument vector - socket path, control input, horizon, jobs and job parameters
+ */
+int main(int argc, char ** argv){
+
+    bool quiet = false;
+    bool stop_server = false;
+    bool expect_error = false;
+    vector<string> args;
+    for (int i = 1; i < argc; i++) {
+        string option = argv[i];
+        if (option == "--quiet") {
+            quiet = true;
+        }else if (option == "--shutdown") {
+            stop_server = true;
+        }else if (option == "--expect-error") {
+            expect_error = true;
+        }else {
+            args.push_back(option);
+        }
+    }
+    if (args.size() < 2){
+        cout << "you are using this program with wrong parameters. The program should be invoked as follow:";
+        cout << argv[0] << " socket path, control input [horizon] [jobs] [job parameters] [--quiet] [--shutdown] [--expect-error]" << endl;
+        return 1;
+    }
+    string socket_path = args[0];
+    string input = args[1];
+    string horizon = (args.size() > 2) ? args[2] : "04:00:00:000";
+    int jobs = (args.size() > 3) ? atoi(args[3].c_str()) : 1;
+    string parameters;
+    for (size_t i = 4; i < args.size(); i++) {
+        parameters += " " + args[i];
+    }
+
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (sockaddr*) &address, sizeof(address)) < 0) {
+        cout << "can't connect to " << socket_path << ": " << strerror(errno) << endl;
+        return 1;
+    }
+
+    /** All the jobs are sent at once, the server runs them on its workers */
+    auto start = hclock::now();
+    ostringstream requests;
+    for (int job = 1; job <= jobs; job++) {
+        requests << "RUN " << job << " " << input << " " << horizon << parameters << "\n";
+    }
+    requests << (stop_server ? "SHUTDOWN\n" : "QUIT\n");
+    if (!send_all(fd, requests.str())) {
+        cout << "can't send the jobs: " << strerror(errno) << endl;
+        return 1;
+    }
+
+    /** The server closes the connection once every job is answered */
+    string answers;
+    char buffer[65536];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+        answers.append(buffer, n);
+    }
+    close(fd);
+    double secs = chrono::duration_cast<chrono::duration<double, ratio<1>>>(hclock::now() - start).count();
+
+    int ended = 0, errors = 0;
+    istringstream answer_stream(answers);
+    string line;
+    while (getline(answer_stream, line)) {
+        if (line.compare(0, 4, "END ") == 0) {
+            ++ended;
+        }else if (line.compare(0, 6, "ERROR ") == 0) {
+            ++errors;
+            if (quiet) {
+                cout << line << endl;
+            }
+        }
+    }
+    if (!quiet) {
+        cout << answers;
+    }
+    cout << ended << " of " << jobs << " jobs answered in " << secs << "sec ("
+         << (secs > 0 ? ended / secs : 0) << " jobs/sec), " << errors << " errors" << endl;
+    if (expect_error) {
+        return (errors == jobs && ended == 0) ? 0 : 1;
+    }
+    return (ended == jobs && errors == 0) ? 0 : 1;
+}
@@ -0,0 +1,404 @@
+/** \brief Concurrent test driver for the receiver, sender and subnet models
+ *
+ * The driver reads a manifest of scenarios and runs them on a pool of threads.
+ * Every scenario builds its own TOP model, logs into its own in-memory sink
+ * (see thread_sink.hpp), converts the trace with output_file_evolution and
+ * compares the result with a golden csv. Nothing is written to test/data, so
+ * parallel runs don't overwrite each other's files.
+ *
+ * Manifest format, one scenario per line (lines starting with # are ignored):
+ *      receiver <golden csv> <input> [key=value]...
+ *      subnet   <golden csv> <input> [key=value]...
+ *      sender   <golden csv> <control input> <ack input> [key=value]...
+ * The key=value parameters are the ones of abp_set_parameter (abp_parameters.hpp),
+ * e.g. ack_delay=00:00:05:000 or bags=queue, and are set on the model under test.
+ *
+ * Usage: ./bin/TEST_DRIVER [manifest] [threads] [repeat] [--flat]
+ * repeat runs every scenario of the manifest that many times (default 1).
+ * --flat runs the scenarios on the flat kernel (flat_kernel.hpp) instead of the
+ * cadmium runner, both must match the same goldens.
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+#include <cadmium/modeling/coupling.hpp>
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/dynamic_model_translator.hpp>
+#include <cadmium/concept/coupled_model_assert.hpp>
+#include <cadmium/modeling/dynamic_coupled.hpp>
+#include <cadmium/modeling/dynamic_atomic.hpp>
+#include <cadmium/engine/pdevs_dynamic_runner.hpp>
+#include <cadmium/logger/tuple_to_ostream.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+#include "../../../lib/DESTimes/include/NDTime.hpp"
+#include "../../../lib/vendor/iestream.hpp"
+
+#include "../../../include/data_structures/message.hpp"
+#include "../../../include/simulator_renaissance.hpp"
+#include "../../../include/thread_sink.hpp"
+#include "../../../include/mem_instrumentation.hpp"
+#include "../../../include/flat_kernel.hpp"
+
+#include "../../../include/sender_cadmium.hpp"
+#include "../../../include/receiver_cadmium.hpp"
+#include "../../../include/subnet_cadmium.hpp"
+#include "../../../include/abp_parameters.hpp"
+
+using namespace std;
+
+using hclock=chrono::high_resolution_clock;
+using TIME = NDTime;
+
+/**Default manifest listing the scenarios*/
+char manifest_file[] = "test/data/scenarios.txt";
+/**Run metrics file, the measures of every phase of the driver are appended to it*/
+char run_metrics_file[] = "test/data/run_metrics.csv";
+
+/***** SETING OUTPUT PORTS FOR COUPLEDs *****/
+struct outp : public cadmium::out_port<message_t>{};
+struct outp_out : public cadmium::out_port<message_t>{};
+struct outp_ack : public cadmium::out_port<message_t>{};
+struct outp_data : public cadmium::out_port<message_t>{};
+struct outp_pack : public cadmium::out_port<message_t>{};
+
+/********************************************/
+/****** APPLICATION GENERATOR *******************/
+/********************************************/
+template<typename T>
+class ApplicationGen : public iestream_input<message_t,T> {
+public:
+  ApplicationGen() = default;
+  ApplicationGen(const char* file_path) : iestream_input<message_t,T>(file_path) {}
+};
+
+/**
+ * Models under test, configured with the parameters of their scenario
+ */
+template<typename T>
+class ConfiguredSender : public Sender<T> {
+public:
+  ConfiguredSender(const abp_parameters<T> &parameters) {
+    abp_configure<T>(*this, parameters);
+  }
+};
+
+template<typename T>
+class ConfiguredReceiver : public Receiver<T> {
+public:
+  ConfiguredReceiver(const abp_parameters<T> &parameters) {
+    abp_configure<T>(*this, parameters);
+  }
+};
+
+template<typename T>
+class ConfiguredSubnet : public Subnet<T> {
+public:
+  ConfiguredSubnet(const abp_parameters<T> &parameters) {
+    abp_configure<T>(*this, parameters);
+  }
+};
+
+/**
+ * Structure holding a scenario of the manifest and its result
+ */
+struct scenario{
+    string model;          /**< receiver, sender or subnet */
+    string golden;         /**< Expected output_file_evolution csv */
+    vector<string> inputs; /**< Input files of the generators */
+    abp_parameters<TIME> parameters; /**< Parameters of the model under test */
+    bool passed = false;
+    string message;        /**< First difference or error */
+    double secs = 0;
+};
+
+/**
+ * @brief      Builds the TOP model of the receiver test
+ */
+static shared_ptr<cadmium::dynamic::modeling::coupled<TIME>> make_receiver_top(const scenario &s) {
+    const char * i_input = s.inputs[0].c_str();
+    shared_ptr<cadmium::dynamic::modeling::model> generator = cadmium::dynamic::translate::make_dynamic_atomic_model<ApplicationGen, TIME, const char* >("generator" , move(i_input));
+    shared_ptr<cadmium::dynamic::modeling::model> receiver1 = cadmium::dynamic::translate::make_dynamic_atomic_model<ConfiguredReceiver, TIME, abp_parameters<TIME>>("receiver1", abp_parameters<TIME>(s.parameters));
+
+    cadmium::dynamic::modeling::Ports iports_TOP = {};
+    cadmium::dynamic::modeling::Ports oports_TOP = {typeid(outp)};
+    cadmium::dynamic::modeling::Models submodels_TOP = {generator, receiver1};
+    cadmium::dynamic::modeling::EICs eics_TOP = {};
+    cadmium::dynamic::modeling::EOCs eocs_TOP = {
+        cadmium::dynamic::translate::make_EOC<receiver_defs::out,outp>("receiver1")
+    };
+    cadmium::dynamic::modeling::ICs ics_TOP = {
+        cadmium::dynamic::translate::make_IC<iestream_input_defs<message_t>::out,receiver_defs::in>("generator","receiver1")
+    };
+    return make_shared<cadmium::dynamic::modeling::coupled<TIME>>(
+        "TOP", submodels_TOP, iports_TOP, oports_TOP, eics_TOP, eocs_TOP, ics_TOP);
+}
+
+/**
+ * @brief      Builds the TOP model of the subnet test
+ */
+static shared_ptr<cadmium::dynamic::modeling::coupled<TIME>> make_subnet_top(const scenario &s) {
+    const char * i_input = s.inputs[0].c_str();
+    shared_ptr<cadmium::dynamic::modeling::model> generator = cadmium::dynamic::translate::make_dynamic_atomic_model<ApplicationGen, TIME, const char* >("generator" , move(i_input));
+    shared_ptr<cadmium::dynamic::modeling::model> subnet1 = cadmium::dynamic::translate::make_dynamic_atomic_model<ConfiguredSubnet, TIME, abp_parameters<TIME>>("subnet1", abp_parameters<TIME>(s.parameters));
+
+    cadmium::dynamic::modeling::Ports iports_TOP = {};
+    cadmium::dynamic::modeling::Ports oports_TOP = {typeid(outp_out)};
+    cadmium::dynamic::modeling::Models submodels_TOP = {generator, subnet1};
+    cadmium::dynamic::modeling::EICs eics_TOP = {};
+    cadmium::dynamic::modeling::EOCs eocs_TOP = {
+        cadmium::dynamic::translate::make_EOC<subnet_defs::out,outp_out>("subnet1")
+    };
+    cadmium::dynamic::modeling::ICs ics_TOP = {
+        cadmium::dynamic::translate::make_IC<iestream_input_defs<message_t>::out,subnet_defs::in>("generator","subnet1")
+    };
+    return make_shared<cadmium::dynamic::modeling::coupled<TIME>>(
+        "TOP", submodels_TOP, iports_TOP, oports_TOP, eics_TOP, eocs_TOP, ics_TOP);
+}
+
+/**
+ * @brief      Builds the TOP model of the sender test
+ */
+static shared_ptr<cadmium::dynamic::modeling::coupled<TIME>> make_sender_top(const scenario &s) {
+    const char * i_input_control = s.inputs[0].c_str();
+    const char * i_input_ack = s.inputs[1].c_str();
+    shared_ptr<cadmium::dynamic::modeling::model> generator_con = cadmium::dynamic::translate::make_dynamic_atomic_model<ApplicationGen, TIME, const char* >("generator_con" , move(i_input_control));
+    shared_ptr<cadmium::dynamic::modeling::model> generator_ack = cadmium::dynamic::translate::make_dynamic_atomic_model<ApplicationGen, TIME, const char* >("generator_ack" , move(i_input_ack));
+    shared_ptr<cadmium::dynamic::modeling::model> sender1 = cadmium::dynamic::translate::make_dynamic_atomic_model<ConfiguredSender, TIME, abp_parameters<TIME>>("sender1", abp_parameters<TIME>(s.parameters));
+
+    cadmium::dynamic::modeling::Ports iports_TOP = {};
+    cadmium::dynamic::modeling::Ports oports_TOP = {typeid(outp_data),typeid(outp_pack),typeid(outp_ack)};
+    cadmium::dynamic::modeling::Models submodels_TOP = {generator_con, generator_ack, sender1};
+    cadmium::dynamic::modeling::EICs eics_TOP = {};
+    cadmium::dynamic::modeling::EOCs eocs_TOP = {
+        cadmium::dynamic::translate::make_EOC<sender_defs::packetSentOut,outp_pack>("sender1"),
+        cadmium::dynamic::translate::make_EOC<sender_defs::ackReceivedOut,outp_ack>("sender1"),
+        cadmium::dynamic::translate::make_EOC<sender_defs::dataOut,outp_data>("sender1")
+    };
+    cadmium::dynamic::modeling::ICs ics_TOP = {
+        cadmium::dynamic::translate::make_IC<iestream_input_defs<message_t>::out,sender_defs::controlIn>("generator_con","sender1"),
+        cadmium::dynamic::translate::make_IC<iestream_input_defs<message_t>::out,sender_defs::ackIn>("generator_ack","sender1")
+    };
+    return make_shared<cadmium::dynamic::modeling::coupled<TIME>>(
+        "TOP", submodels_TOP, iports_TOP, oports_TOP, eics_TOP, eocs_TOP, ics_TOP);
+}
+
+/**
+ * @brief      Adds the models of the TOP model of a scenario to a flat kernel
+ * The ids and the order of the models are the ones of make_*_top, so both kernels
+ * write the same trace.
+ */
+static void make_flat_top(flat_kernel<TIME> &kernel, const scenario &s) {
+    int top = kernel.add_coupled("TOP");
+    if (s.model == "receiver") {
+        kernel.add_atomic<ApplicationGen>("generator", top, s.inputs[0].c_str());
+        kernel.add_atomic<ConfiguredReceiver>("receiver1", top, s.parameters);
+        kernel.connect<iestream_input_defs<message_t>::out, receiver_defs::in>("generator", "receiver1");
+    }else if (s.model == "subnet") {
+        kernel.add_atomic<ApplicationGen>("generator", top, s.inputs[0].c_str());
+        kernel.add_atomic<ConfiguredSubnet>("subnet1", top, s.parameters);
+        kernel.connect<iestream_input_defs<message_t>::out, subnet_defs::in>("generator", "subnet1");
+    }else {
+        kernel.add_atomic<ApplicationGen>("generator_con", top, s.inputs[0].c_str());
+        kernel.add_atomic<ApplicationGen>("generator_ack", top, s.inputs[1].c_str());
+        kernel.add_atomic<ConfiguredSender>("sender1", top, s.parameters);
+        kernel.connect<iestream_input_defs<message_t>::out, sender_defs::controlIn>("generator_con", "sender1");
+        kernel.connect<iestream_input_defs<message_t>::out, sender_defs::ackIn>("generator_ack", "sender1");
+    }
+}
+
+/**
+ * @brief      Compares a csv produced in memory with the golden file line by line
+ *
+ * Trailing empty lines are ignored on both sides.
+ * @return     true if equal, otherwise message describes the first difference
+ */
+static bool compare_with_golden(const string &csv, const string &golden, string &message) {
+    ifstream golden_stream(golden);
+    if (!golden_stream.is_open()) {
+        message = golden + " doesn't exist";
+        return false;
+    }
+    istringstream csv_stream(csv);
+    string expected, actual;
+    int line = 0;
+    while (true) {
+        ++line;
+        bool has_expected = static_cast<bool>(getline(golden_stream, expected));
+        bool has_actual = static_cast<bool>(getline(csv_stream, actual));
+        if (!has_expected && !has_actual) {
+            return true;
+        }
+        if (!has_expected) expected = "";
+        if (!has_actual) actual = "";
+        if (expected != actual) {
+            if ((!has_expected && actual.empty()) || (!has_actual && expected.empty())) {
+                continue;
+            }
+            message = "line " + to_string(line) + ": expected \"" + expected +
+                      "\" got \"" + actual + "\"";
+            return false;
+        }
+    }
+}
+
+/**
+ * @brief      Runs one scenario in the calling thread
+ */
+static void run_scenario(scenario &s, bool flat) {
+    auto start = hclock::now();
+    if (!s.message.empty()) {
+        return;
+    }
+    if (!((s.model == "receiver" && s.inputs.size() == 1) || (s.model == "subnet" && s.inputs.size() == 1)
+          || (s.model == "sender" && s.inputs.size() == 2))) {
+        s.message = "unknown model or wrong number of inputs";
+        return;
+    }
+
+    ostringstream trace;
+    if (flat) {
+        flat_kernel<TIME> kernel(trace);
+        make_flat_top(kernel, s);
+        kernel.run_until(NDTime("04:00:00:000"));
+    }else {
+        shared_ptr<cadmium::dynamic::modeling::coupled<TIME>> TOP;
+        if (s.model == "receiver") {
+            TOP = make_receiver_top(s);
+        }else if (s.model == "subnet") {
+            TOP = make_subnet_top(s);
+        }else {
+            TOP = make_sender_top(s);
+        }
+        thread_sink_guard guard(trace);
+        cadmium::dynamic::engine::runner<NDTime, thread_logger_top<NDTime>> r(TOP, {0});
+        r.run_until(NDTime("04:00:00:000"));
+    }
+
+    istringstream trace_stream(trace.str());
+    ostringstream csv;
+    output_file_evolution(trace_stream, csv);
+    s.passed = compare_with_golden(csv.str(), s.golden, s.message);
+    s.secs = chrono::duration_cast<chrono::duration<double, ratio<1>>>(hclock::now() - start).count();
+}
+
+/**
+ * @brief      Reads the scenarios of a manifest
+ * A scenario whose parameters are invalid keeps the error as its message and fails.
+ */
+static vector<scenario> read_manifest(const string &path) {
+    vector<scenario> scenarios;
+    ifstream i_d_stream(path);
+    string line;
+    while (getline(i_d_stream, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        istringstream fields(line);
+        scenario s;
+        string input;
+        fields >> s.model >> s.golden;
+        while (fields >> input) {
+            size_t equal = input.find('=');
+            if (equal == string::npos) {
+                s.inputs.push_back(input);
+            }else if (s.message.empty()) {
+                s.message = abp_set_parameter(input.substr(0, equal), input.substr(equal + 1), s.parameters);
+            }
+        }
+        if (s.message.empty()) {
+            s.message = abp_check_parameters(s.parameters);
+        }
+        if (!s.model.empty()) {
+            scenarios.push_back(s);
+        }
+    }
+    return scenarios;
+}
+
+/**\brief  main function
+ *
+ * @param argc Integer argument - These are counting the command line arguments
+ * @param argv Argument vector - manifest, number of threads, repeat count and --flat
+ */
+int main(int argc, char ** argv){
+
+    bool flat = false;
+    vector<string> args;
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--flat") {
+            flat = true;
+        }else {
+            args.push_back(argv[i]);
+        }
+    }
+    string manifest = (args.size() > 0) ? args[0] : manifest_file;
+    unsigned int threads = (args.size() > 1) ? atoi(args[1].c_str()) : thread::hardware_concurrency();
+    int repeat = (args.size() > 2) ? atoi(args[2].c_str()) : 1;
+    if (threads == 0) {
+        threads = 1;
+    }
+
+    /** Measures of every phase, the scenarios phase covers all the threads */
+    phase_metrics metrics("TEST_DRIVER");
+    metrics.begin("manifest");
+    vector<scenario> manifest_scenarios = read_manifest(manifest);
+    if (manifest_scenarios.empty()) {
+        cout << manifest << " has no scenarios" << endl;
+        return 1;
+    }
+    vector<scenario> scenarios;
+    for (int i = 0; i < repeat; i++) {
+        scenarios.insert(scenarios.end(), manifest_scenarios.begin(), manifest_scenarios.end());
+    }
+
+    auto start = hclock::now();
+    metrics.begin("scenarios");
+
+    /** Every worker takes the next scenario until none is left */
+    atomic<size_t> next_scenario(0);
+    vector<thread> pool;
+    for (unsigned int i = 0; i < min<size_t>(threads, scenarios.size()); i++) {
+        pool.emplace_back([&]() {
+            size_t index;
+            while ((index = next_scenario++) < scenarios.size()) {
+                run_scenario(scenarios[index], flat);
+            }
+        });
+    }
+    for (auto &worker : pool) {
+        worker.join();
+    }
+    metrics.end();
+
+    auto elapsed = chrono::duration_cast<chrono::duration<double, ratio<1>>>(hclock::now() - start).count();
+
+    int failed = 0;
+    for (const auto &s : scenarios) {
+        cout << (s.passed ? "PASS " : "FAIL ") << s.model << " " << s.golden
+             << " (" << s.secs << "sec)";
+        if (!s.passed) {
+            cout << ": " << s.message;
+            ++failed;
+        }
+        cout << endl;
+    }
+    cout << scenarios.size() - failed << "/" << scenarios.size() << " scenarios passed on "
+         << pool.size() << " threads in " << elapsed << "sec" << endl;
+    metrics.print(cout);
+    metrics.write(run_metrics_file);
+    return failed == 0 ? 0 : 1;
+}
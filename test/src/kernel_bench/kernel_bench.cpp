@@ -0,0 +1,205 @@
+/** \brief Side by side benchmark of the cadmium runner and the flat kernel
+ *
+ * For every number of pairs M of the list, the benchmark builds the pairs 1..M of
+ * make_abp_pairs_top for cadmium::dynamic::engine::runner and the same models with
+ * make_abp_pairs_flat for flat_kernel, runs both into an in-memory trace and records:
+ *      - events/sec  (message events of the trace per second of run time)
+ *      - the speedup of the flat kernel
+ *      - heap allocations per event of both runs, counted by the operator new
+ *        hooks of mem_instrumentation.cpp, always linked in this program
+ *      - heap allocations per transition of the flat kernel in steady state: the
+ *        kernel runs without trace for the first quarter of the run, then the
+ *        allocations of the rest of the run are counted
+ *      - whether both traces are identical
+ * Every run is repeated and the fastest one is kept. The results are written to
+ * data/bench/kernel_results.csv and the benchmark exits with status 1 if any pair
+ * of traces differs.
+ *
+ * Usage: ./bin/KERNEL_BENCH <control input> [end time] [M list, e.g. 1,4,16] [repeat]
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <sys/stat.h>
+
+#include <cadmium/engine/pdevs_dynamic_runner.hpp>
+#include <cadmium/logger/tuple_to_ostream.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+#include "../../../lib/DESTimes/include/NDTime.hpp"
+
+#include "../../../include/simulator_renaissance.hpp"
+#include "../../../include/trace_reader.hpp"
+#include "../../../include/thread_sink.hpp"
+#include "../../../include/abp_topology.hpp"
+#include "../../../include/flat_kernel.hpp"
+#include "../../../include/mem_instrumentation.hpp"
+
+using namespace std;
+
+using hclock=chrono::high_resolution_clock;
+using TIME = NDTime;
+
+/**File the results are written to*/
+char kernel_results_file[] = "./data/bench/kernel_results.csv";
+
+/**
+ * Structure holding the fastest run of one backend
+ */
+struct kernel_run{
+    double secs = 0;
+    long long allocations = 0;
+    string trace;
+};
+
+/**
+ * @brief      Runs the pairs with the cadmium runner
+ */
+static kernel_run run_cadmium(const string &input, int pairs, const string &end_time) {
+    kernel_run run;
+    ostringstream trace;
+    long long allocations_before = mem_snapshot().allocations;
+    auto start = hclock::now();
+    {
+        thread_sink_guard guard(trace);
+        auto TOP = make_abp_pairs_top<TIME>(input.c_str(), 1, pairs);
+        cadmium::dynamic::engine::runner<NDTime, thread_logger_top<NDTime>> r(TOP, {0});
+        r.run_until(NDTime(end_time.c_str()));
+    }
+    run.secs = chrono::duration_cast<chrono::duration<double, ratio<1>>>(hclock::now() - start).count();
+    run.allocations = mem_snapshot().allocations - allocations_before;
+    run.trace = trace.str();
+    return run;
+}
+
+/**
+ * @brief      Runs the pairs with the flat kernel
+ */
+static kernel_run run_flat(const string &input, int pairs, const string &end_time) {
+    kernel_run run;
+    ostringstream trace;
+    long long allocations_before = mem_snapshot().allocations;
+    auto start = hclock::now();
+    {
+        flat_kernel<TIME> kernel(trace);
+        make_abp_pairs_flat(kernel, input.c_str(), 1, pairs);
+        kernel.run_until(NDTime(end_time.c_str()));
+    }
+    run.secs = chrono::duration_cast<chrono::duration<double, ratio<1>>>(hclock::now() - start).count();
+    run.allocations = mem_snapshot().allocations - allocations_before;
+    run.trace = trace.str();
+    return run;
+}
+
+/**
+ * @brief      Counts the allocations of the flat kernel once the first quarter of the run is done
+ *
+ * @param[out] transitions  transitions run after the first quarter
+ * @return     allocations made after the first quarter
+ */
+static long steady_allocations(const string &input, int pairs, const string &end_time, long long &transitions) {
+    flat_kernel<TIME> kernel;
+    make_abp_pairs_flat(kernel, input.c_str(), 1, pairs);
+    string warm_up = format_time_ms(parse_time_ms(end_time) / 4);
+    kernel.run_until(NDTime(warm_up.c_str()));
+    NDTime end(end_time.c_str());
+    long long transitions_before = kernel.transitions();
+    long long allocations_before = mem_snapshot().allocations;
+    kernel.run_until(end);
+    long steady = mem_snapshot().allocations - allocations_before;
+    transitions = kernel.transitions() - transitions_before;
+    return steady;
+}
+
+/**
+ * @brief      Keeps the fastest of repeat runs
+ */
+template<typename RUN>
+static kernel_run fastest(RUN run, int repeat) {
+    kernel_run best = run();
+    for (int i = 1; i < repeat; i++) {
+        kernel_run next = run();
+        if (next.secs < best.secs) {
+            best = next;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief      Counts the message events of a trace
+ */
+static long count_events(const string &trace) {
+    istringstream i_d_stream(trace);
+    trace_reader reader(i_d_stream);
+    trace_record record;
+    long events = 0;
+    while (reader.next_record(record)) {
+        events++;
+    }
+    return events;
+}
+
+/**\brief  main function
+ *
+ * @param argc Integer argument - These are counting the command line arguments
+ * @param argv Argument vector - control input, end time, list of M and repeat count
+ */
+int main(int argc, char ** argv){
+
+    if (argc < 2){
+        cout << "you are using this program with wrong parameters. The program should be invoked as follow:";
+        cout << argv[0] << " path to the input file [end time] [M list] [repeat]" << endl;
+        return 1;
+    }
+    string input_data_control = argv[1];
+    string end_time = (argc > 2) ? argv[2] : "04:00:00:000";
+    vector<string> pair_counts = split((argc > 3) ? argv[3] : "1,4,16", ',');
+    int repeat = (argc > 4) ? max(1, atoi(argv[4])) : 3;
+    mkdir("./data/bench", 0755);
+
+    ofstream results(kernel_results_file, ofstream::out | ofstream::trunc);
+    results << "Pairs,Events,CadmiumSecs,CadmiumEventsPerSec,CadmiumAllocsPerEvent,"
+            << "FlatSecs,FlatEventsPerSec,FlatAllocsPerEvent,Speedup,SteadyTransitions,SteadyAllocs,Identical" << endl;
+    bool all_identical = true;
+
+    cout << "pairs   events   cadmium ev/s   flat ev/s   speedup   cadmium allocs/ev   flat allocs/ev"
+         << "   steady allocs/transition   trace" << endl;
+    for (const string &pair_count : pair_counts) {
+        int pairs = stoi(pair_count);
+        kernel_run cadmium_run = fastest([&]() { return run_cadmium(input_data_control, pairs, end_time); }, repeat);
+        kernel_run flat_run = fastest([&]() { return run_flat(input_data_control, pairs, end_time); }, repeat);
+
+        long events = count_events(cadmium_run.trace);
+        bool identical = cadmium_run.trace == flat_run.trace;
+        all_identical &= identical;
+        double cadmium_rate = cadmium_run.secs > 0 ? events / cadmium_run.secs : 0;
+        double flat_rate = flat_run.secs > 0 ? events / flat_run.secs : 0;
+        double speedup = flat_run.secs > 0 ? cadmium_run.secs / flat_run.secs : 0;
+        double cadmium_allocs = events > 0 ? (double) cadmium_run.allocations / events : 0;
+        double flat_allocs = events > 0 ? (double) flat_run.allocations / events : 0;
+        long long steady_transitions = 0;
+        long steady = steady_allocations(input_data_control, pairs, end_time, steady_transitions);
+        double steady_allocs = steady_transitions > 0 ? (double) steady / steady_transitions : 0;
+
+        cout << pairs << "   " << events << "   " << cadmium_rate << "   " << flat_rate << "   "
+             << speedup << "x   " << cadmium_allocs << "   " << flat_allocs << "   " << steady_allocs
+             << " (" << steady << " in " << steady_transitions << ")   "
+             << (identical ? "identical" : "DIFFERENT") << endl;
+        results << pairs << "," << events << "," << cadmium_run.secs << "," << cadmium_rate << ","
+                << cadmium_allocs << "," << flat_run.secs << "," << flat_rate << "," << flat_allocs << ","
+                << speedup << "," << steady_transitions << "," << steady << "," << (identical ? 1 : 0) << endl;
+    }
+    cout << "Results written to " << kernel_results_file << endl;
+    return all_identical ? 0 : 1;
+}
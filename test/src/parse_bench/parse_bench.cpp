@@ -0,0 +1,212 @@
+/** \brief Microbenchmark of the scanning kernels of the trace parsers
+ *
+ * The benchmark loads a raw trace, repeats it in memory and compares the kernels of
+ * trace_scan.hpp with the std::string code they replace:
+ *      - time conversion: split(t, ':') and stoi against parse_fixed_time_ms, on
+ *        every timestamp line of the trace
+ *      - structural scan: one std::string::find loop per character (',', '{', '}',
+ *        ':', '[' and ']') against scan_trace_line with the scalar, SSE2 and AVX2
+ *        kernels, on every message line of the trace
+ *      - output_file_evolution of the whole trace, in MB/s
+ * Both sides must give the same times and positions, the benchmark exits with
+ * status 1 otherwise. Every measure is repeated and the fastest run is kept.
+ *
+ * Usage: ./bin/PARSE_BENCH [raw trace] [copies] [repeat]
+ */
+/**
+ * Hamza Sadruddin
+ * Saad Hasan
+ * Carleton University
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+
+#include "../../../include/simulator_renaissance.hpp"
+#include "../../../include/trace_scan.hpp"
+
+using namespace std;
+
+using hclock=chrono::high_resolution_clock;
+
+/**
+ * @brief      Fastest of repeated runs of a function, in seconds
+ */
+template<typename FUNCTION>
+static double fastest(int repeat, FUNCTION function) {
+    double best = 0;
+    for (int r = 0; r < repeat; r++) {
+        auto start = hclock::now();
+        function();
+        double secs = chrono::duration_cast<chrono::duration<double, ratio<1>>>(hclock::now() - start).count();
+        best = (r == 0) ? secs : min(best, secs);
+    }
+    return best;
+}
+
+/**
+ * @brief      Time conversion of output_time_statistics before trace_scan.hpp
+ */
+static long long split_time_ms(const string &time_string) {
+    vector<string> time = split(time_string, ':');
+    return ((stoll(time[0]) * 60 + stoll(time[1])) * 60 + stoll(time[2])) * 1000 + stoll(time[3]);
+}
+
+/**
+ * @brief      Positions of a character with std::string::find
+ */
+static void find_all(const string &line, char c, vector<uint32_t> &positions) {
+    positions.clear();
+    for (size_t pos = line.find(c); pos != string::npos; pos = line.find(c, pos + 1)) {
+        positions.push_back((uint32_t) pos);
+    }
+}
+
+/**
+ * @brief      Structural scan with one find loop per character
+ */
+static void find_scan(const string &line, trace_line_scan &scan) {
+    find_all(line, ',', scan.commas);
+    find_all(line, '{', scan.braces_open);
+    find_all(line, '}', scan.braces_close);
+    find_all(line, ':', scan.colons);
+    find_all(line, '[', scan.squares_open);
+    find_all(line, ']', scan.squares_close);
+}
+
+static bool same_scan(const trace_line_scan &a, const trace_line_scan &b) {
+    return a.commas == b.commas && a.braces_open == b.braces_open && a.braces_close == b.braces_close
+           && a.colons == b.colons && a.squares_open == b.squares_open && a.squares_close == b.squares_close;
+}
+
+/**\brief  main function
+ *
+ * @param argc Integer argument - These are counting the command line arguments
+ * @param argv Argument vector - trace, copies and repeat
+ */
+int main(int argc, char ** argv){
+
+    string trace_path = (argc > 1) ? argv[1] : "data/abp_output.txt";
+    int copies = (argc > 2) ? atoi(argv[2]) : 200;
+    int repeat = (argc > 3) ? atoi(argv[3]) : 5;
+    ifstream trace_file(trace_path);
+    if (!trace_file || copies <= 0 || repeat <= 0) {
+        cout << "you are using this program with wrong parameters. The program should be invoked as follow:";
+        cout << argv[0] << " [raw trace] [copies] [repeat]" << endl;
+        return 1;
+    }
+    stringstream content;
+    content << trace_file.rdbuf();
+    string trace;
+    for (int c = 0; c < copies; c++) {
+        trace += content.str();
+    }
+
+    vector<string> times, lines;
+    istringstream trace_stream(trace);
+    string line;
+    while (getline(trace_stream, line)) {
+        if (line.length() == 12) {
+            times.push_back(line);
+        }else if (line.length() > 12) {
+            lines.push_back(line);
+        }
+    }
+    if (times.empty() || lines.empty()) {
+        cout << trace_path << " has no timestamp or message line" << endl;
+        return 1;
+    }
+    size_t line_bytes = 0;
+    for (const string &l : lines) {
+        line_bytes += l.size();
+    }
+    cout << trace_path << " x" << copies << ": " << trace.size() / 1e6 << " MB, " << times.size() << " times, "
+         << lines.size() << " message lines" << endl;
+    int status = 0;
+
+    /** Time conversion */
+    long long split_sum = 0, fixed_sum = 0;
+    double split_secs = fastest(repeat, [&]() {
+        split_sum = 0;
+        for (const string &t : times) {
+            split_sum += split_time_ms(t);
+        }
+    });
+    double fixed_secs = fastest(repeat, [&]() {
+        fixed_sum = 0;
+        for (const string &t : times) {
+            fixed_sum += parse_fixed_time_ms(t.data());
+        }
+    });
+    if (split_sum != fixed_sum) {
+        status = 1;
+    }
+    for (const string &t : times) {
+        if (split_time_ms(t) != parse_fixed_time_ms(t.data())) {
+            cout << "time " << t << " converted differently" << endl;
+            status = 1;
+            break;
+        }
+    }
+    cout << "Kernel,ns per item,Speedup" << endl;
+    cout << "split+stoi time," << split_secs * 1e9 / times.size() << ",1" << endl;
+    cout << "parse_fixed_time_ms," << fixed_secs * 1e9 / times.size() << "," << split_secs / fixed_secs << endl;
+
+    /** Structural scan */
+    trace_line_scan reference, scanned;
+    size_t positions = 0;
+    double find_secs = fastest(repeat, [&]() {
+        positions = 0;
+        for (const string &l : lines) {
+            find_scan(l, reference);
+            positions += reference.commas.size() + reference.colons.size();
+        }
+    });
+    cout << "find per character," << find_secs * 1e9 / lines.size() << ",1" << endl;
+    vector<pair<string, trace_scan_isa>> kernels = {{"scalar", trace_scan_isa::scalar}};
+#ifdef TRACE_SCAN_X86
+    kernels.push_back({"sse2", trace_scan_isa::sse2});
+    if (trace_scan_best_isa() == trace_scan_isa::avx2) {
+        kernels.push_back({"avx2", trace_scan_isa::avx2});
+    }
+#endif
+    for (const auto &kernel : kernels) {
+        size_t kernel_positions = 0;
+        double secs = fastest(repeat, [&]() {
+            kernel_positions = 0;
+            for (const string &l : lines) {
+                scan_trace_line(l.data(), l.size(), scanned, kernel.second);
+                kernel_positions += scanned.commas.size() + scanned.colons.size();
+            }
+        });
+        if (kernel_positions != positions) {
+            status = 1;
+        }
+        for (const string &l : lines) {
+            find_scan(l, reference);
+            scan_trace_line(l.data(), l.size(), scanned, kernel.second);
+            if (!same_scan(reference, scanned)) {
+                cout << kernel.first << " scanned differently: " << l << endl;
+                status = 1;
+                break;
+            }
+        }
+        cout << "scan_trace_line " << kernel.first << "," << secs * 1e9 / lines.size() << "," << find_secs / secs
+             << " (" << line_bytes / secs / 1e9 << " GB/s)" << endl;
+    }
+
+    /** Whole conversion */
+    double evolution_secs = fastest(repeat, [&]() {
+        istringstream input(trace);
+        ostringstream output;
+        output_file_evolution(input, output);
+    });
+    cout << "output_file_evolution " << trace.size() / evolution_secs / 1e6 << " MB/s" << endl;
+    return status;
+}
@@ -19,6 +19,7 @@
 
 #include "../../../include/data_structures/message.hpp"
 #include "../../../include/simulator_renaissance.hpp"
+#include "../../../include/mem_instrumentation.hpp"
 
 #include "../../../include/sender_cadmium.hpp"
 
@@ -31,6 +32,8 @@ using TIME = NDTime;
 char output_file[] = "test/data/sender_test_output.txt";
 /**Output file path of the function output_file_evolution*/
 char mod_output_file[] = "test/data/sender_mod_output.csv";
+/**Run metrics file, the measures of every phase of the test are appended to it*/
+char run_metrics_file[] = "test/data/run_metrics.csv";
 /**Output file path of the function output_time_statistics*/
 char time_statistics_file[] = "./test/data/send_time_stats_output.csv";
 
@@ -59,6 +62,9 @@ public:
 int main(){
 
   auto start = hclock::now(); //to measure simulation execution time
+  /** Measures of every phase, see mem_instrumentation.hpp */
+  phase_metrics metrics("SENDER_TEST");
+  metrics.begin("model");
 
 /*************** Loggers *******************/
   static std::ofstream out_data(output_file);
@@ -136,13 +142,17 @@ std::shared_ptr<cadmium::dynamic::modeling::coupled<TIME>> TOP = std::make_share
     auto elapsed1 = std::chrono::duration_cast<std::chrono::duration<double, std::ratio<1>>>(hclock::now() - start).count();
     cout << "Model Created. Elapsed time: " << elapsed1 << "sec" << endl;
     
+    metrics.begin("runner");
     cadmium::dynamic::engine::runner<NDTime, logger_top> r(TOP, {0});
     elapsed1 = std::chrono::duration_cast<std::chrono::duration<double, std::ratio<1>>>(hclock::now() - start).count();
     cout << "Runner Created. Elapsed time: " << elapsed1 << "sec" << endl;
 
     cout << "Simulation starts" << endl;
 
+    metrics.begin("simulation");
     r.run_until(NDTime("04:00:00:000"));
+    out_data.flush();
+    metrics.end();
     auto elapsed = std::chrono::duration_cast<std::chrono::duration<double, std::ratio<1>>>(hclock::now() - start).count();
     cout << "Simulation took:" << elapsed << "sec" << endl;
 
@@ -150,13 +160,20 @@ std::shared_ptr<cadmium::dynamic::modeling::coupled<TIME>> TOP = std::make_share
     * This function which is taking string as input and giving output as strings.
     * which is making the output in good format for human visualziation.
     */
+    metrics.begin("output_file_evolution");
     output_file_evolution(output_file, mod_output_file);
 
     /**
     * The function which is taking the input as string and output as string
     * which is behaving as function calculating time statistics
     */
+    metrics.begin("output_time_statistics");
     output_time_statistics(mod_output_file, time_statistics_file);
 
+    metrics.end();
+    metrics.set_events("simulation", count_csv_events(mod_output_file));
+    metrics.print(cout);
+    metrics.write(run_metrics_file);
+
     return 0;
 }
\ No newline at end of file